@@ -71,6 +71,11 @@ int WebRtcVad_Process(VadInst* handle,
                       const int16_t* audio_frame,
                       size_t frame_length);
 
+// Returns the size in bytes of a VAD instance. The instance holds no pointers,
+// so its state can be copied with memcpy() between handles (e.g. to migrate a
+// live session to another process).
+size_t WebRtcVad_StateSize(void);
+
 // Checks for valid combinations of `rate` and `frame_length`. We support 10,
 // 20 and 30 ms frames and the rates 8000, 16000 and 32000 Hz.
 //
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * 堆分配计数（诊断用，编译期开关 AEROSHELL_COUNT_ALLOCS）
+ *
+ * 设计原则：
+ * 1. 替换全局 operator new / new[]（含 nothrow、对齐版本），每次分配计入
+ *    线程私有计数与进程总数；operator delete 只转发给 free，不计数
+ * 2. 未开启开关时所有接口恒返回 0，替换版 operator new 不参与链接，零开销
+ * 3. 替换函数只能在一个翻译单元中定义：该 TU 在 include 前定义
+ *    AEROSHELL_ALLOC_COUNTER_MAIN
+ *
+ * 用法（断言一段代码不分配）：
+ *   alloc_counter::Scope scope;
+ *   process_one_frame();
+ *   assert(scope.allocations() == 0);
+ */
+namespace alloc_counter {
+
+inline std::atomic<uint64_t> g_total{0};
+inline thread_local uint64_t t_count = 0;   // 零初始化，无 TLS 构造开销
+
+constexpr bool enabled() {
+#ifdef AEROSHELL_COUNT_ALLOCS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 当前线程累计分配次数
+inline uint64_t thread_count() { return t_count; }
+
+// 全进程累计分配次数
+inline uint64_t total() { return g_total.load(std::memory_order_relaxed); }
+
+inline void on_alloc() {
+    ++t_count;
+    g_total.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 统计作用域内本线程的分配次数
+class Scope {
+public:
+    Scope() : start_(thread_count()) {}
+    uint64_t allocations() const { return thread_count() - start_; }
+
+private:
+    uint64_t start_;
+};
+
+}  // namespace alloc_counter
+
+#if defined(AEROSHELL_COUNT_ALLOCS) && defined(AEROSHELL_ALLOC_COUNTER_MAIN)
+
+namespace alloc_counter::detail {
+
+inline void* alloc(size_t n) {
+    on_alloc();
+    return std::malloc(n ? n : 1);
+}
+
+inline void* alloc_aligned(size_t n, std::align_val_t al) {
+    on_alloc();
+    size_t a = static_cast<size_t>(al);
+    size_t sz = (n + a - 1) / a * a;   // aligned_alloc 要求大小是对齐的整数倍
+    return std::aligned_alloc(a, sz ? sz : a);
+}
+
+}  // namespace alloc_counter::detail
+
+void* operator new(size_t n) {
+    if (void* p = alloc_counter::detail::alloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) {
+    if (void* p = alloc_counter::detail::alloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    return alloc_counter::detail::alloc(n);
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    return alloc_counter::detail::alloc(n);
+}
+void* operator new(size_t n, std::align_val_t al) {
+    if (void* p = alloc_counter::detail::alloc_aligned(n, al)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n, std::align_val_t al) {
+    if (void* p = alloc_counter::detail::alloc_aligned(n, al)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * 进程间热交接：监听 socket 传递 + 会话状态快照
+ *
+ * 设计原则：
+ * 1. 旧进程在 Unix 域 socket 上等待新进程连接；交接时用 SCM_RIGHTS 把已绑定的 UDP socket
+ *    原样传过去（同一个 open file description），内核收包队列不断，reuseport 组不变，
+ *    各客户端仍投递到同一下标的 socket
+ * 2. 快照是紧凑的小端二进制流：定长字段直接按字节写入，变长字段带长度前缀；
+ *    每条会话记录带总长度，读端遇到自己不认识的尾部字段可以整条跳过
+ * 3. 只适用于同机、同架构的新旧版本之间，不做字节序转换
+ */
+namespace handoff {
+
+/* ---------- 快照读写 ---------- */
+
+class SnapshotWriter {
+public:
+    template <class T>
+    void put(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a POD value");
+        bytes(&v, sizeof(v));
+    }
+
+    void bytes(const void* p, size_t n) {
+        if (n == 0) return;
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        buf_.insert(buf_.end(), b, b + n);
+    }
+
+    // 带 uint32 长度前缀的变长块
+    void blob(const void* p, size_t n) {
+        put(uint32_t(n));
+        bytes(p, n);
+    }
+
+    // 开始一条记录：先占位总长度，end_record() 时回填
+    size_t begin_record() {
+        size_t at = buf_.size();
+        put(uint32_t(0));
+        return at;
+    }
+
+    void end_record(size_t at) {
+        uint32_t len = uint32_t(buf_.size() - at - sizeof(uint32_t));
+        std::memcpy(buf_.data() + at, &len, sizeof(len));
+    }
+
+    const std::vector<uint8_t>& data() const { return buf_; }
+
+private:
+    std::vector<uint8_t> buf_;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t* p, size_t n) : p_(p), end_(p + n) {}
+
+    // 任何一次越界读之后 ok() 恒为 false，读出的值为零
+    template <class T>
+    bool get(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a POD value");
+        return bytes(&v, sizeof(v));
+    }
+
+    bool bytes(void* out, size_t n) {
+        if (n == 0) return ok_;
+        if (!ok_ || size_t(end_ - p_) < n) {
+            ok_ = false;
+            std::memset(out, 0, n);
+            return false;
+        }
+        std::memcpy(out, p_, n);
+        p_ += n;
+        return true;
+    }
+
+    // 读长度前缀块；长度与 expect 不符时跳过内容并返回 false（不算格式错误）
+    bool blob(void* out, size_t expect) {
+        uint32_t n = 0;
+        if (!get(n)) return false;
+        if (n != expect) {
+            skip(n);
+            return false;
+        }
+        return bytes(out, n);
+    }
+
+    bool skip(size_t n) {
+        if (!ok_ || size_t(end_ - p_) < n) {
+            ok_ = false;
+            return false;
+        }
+        p_ += n;
+        return true;
+    }
+
+    // 切出下一条记录的子读取器，本读取器跳到记录之后
+    SnapshotReader record() {
+        uint32_t n = 0;
+        if (!get(n) || size_t(end_ - p_) < n) {
+            ok_ = false;
+            return SnapshotReader(p_, 0, false);
+        }
+        SnapshotReader sub(p_, n);
+        p_ += n;
+        return sub;
+    }
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return size_t(end_ - p_); }
+
+private:
+    SnapshotReader(const uint8_t* p, size_t n, bool ok) : p_(p), end_(p + n), ok_(ok) {}
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+/* ---------- Unix 域 socket ---------- */
+
+inline bool fill_addr(const std::string& path, sockaddr_un& a) {
+    if (path.size() >= sizeof(a.sun_path)) return false;
+    a = sockaddr_un{};
+    a.sun_family = AF_UNIX;
+    std::memcpy(a.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 旧进程：在 path 上监听（先删除残留的 socket 文件）
+inline int listen_unix(const std::string& path) {
+    sockaddr_un a;
+    if (!fill_addr(path, a)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) < 0 || listen(fd, 1) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 新进程：连接正在运行的旧进程；没有旧进程时返回 -1
+inline int connect_unix(const std::string& path) {
+    sockaddr_un a;
+    if (!fill_addr(path, a)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline bool write_all(int fd, const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    while (n > 0) {
+        ssize_t r = send(fd, b, n, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        b += r;
+        n -= size_t(r);
+    }
+    return true;
+}
+
+inline bool read_all(int fd, void* p, size_t n) {
+    uint8_t* b = static_cast<uint8_t*>(p);
+    while (n > 0) {
+        ssize_t r = recv(fd, b, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        b += r;
+        n -= size_t(r);
+    }
+    return true;
+}
+
+// 等待 fd 可读，超时返回 false
+inline bool wait_readable(int fd, int timeout_ms) {
+    pollfd p{fd, POLLIN, 0};
+    int r;
+    do {
+        r = ::poll(&p, 1, timeout_ms);
+    } while (r < 0 && errno == EINTR);
+    return r > 0;
+}
+
+static constexpr int kMaxFds = 253;   // SCM_MAX_FD
+
+/**
+ * @brief 发送一组 fd（SCM_RIGHTS），附带 uint32 个数作为普通数据
+ */
+inline bool send_fds(int sock, const std::vector<int>& fds) {
+    if (fds.empty() || int(fds.size()) > kMaxFds) return false;
+
+    uint32_t count = uint32_t(fds.size());
+    iovec iov{&count, sizeof(count)};
+
+    std::vector<uint8_t> ctrl(CMSG_SPACE(sizeof(int) * fds.size()));
+    msghdr msg{};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = ctrl.data();
+    msg.msg_controllen = ctrl.size();
+
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type  = SCM_RIGHTS;
+    c->cmsg_len   = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(c), fds.data(), sizeof(int) * fds.size());
+
+    ssize_t r;
+    do {
+        r = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (r < 0 && errno == EINTR);
+    return r == ssize_t(sizeof(count));
+}
+
+inline bool recv_fds(int sock, std::vector<int>& fds) {
+    uint32_t count = 0;
+    iovec iov{&count, sizeof(count)};
+
+    std::vector<uint8_t> ctrl(CMSG_SPACE(sizeof(int) * kMaxFds));
+    msghdr msg{};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = ctrl.data();
+    msg.msg_controllen = ctrl.size();
+
+    ssize_t r;
+    do {
+        r = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    if (r != ssize_t(sizeof(count)) || (msg.msg_flags & MSG_CTRUNC)) return false;
+
+    fds.clear();
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        size_t n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const uint8_t* data = CMSG_DATA(c);
+        for (size_t i = 0; i < n; ++i) {
+            int fd;
+            std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            fds.push_back(fd);
+        }
+    }
+    return fds.size() == count;
+}
+
+// 带 uint64 长度前缀发送整块快照
+inline bool send_blob(int sock, const std::vector<uint8_t>& data) {
+    uint64_t n = data.size();
+    return write_all(sock, &n, sizeof(n)) && write_all(sock, data.data(), data.size());
+}
+
+inline bool recv_blob(int sock, std::vector<uint8_t>& data, size_t max_bytes) {
+    uint64_t n = 0;
+    if (!read_all(sock, &n, sizeof(n)) || n > max_bytes) return false;
+    data.resize(size_t(n));
+    return read_all(sock, data.data(), data.size());
+}
+
+}  // namespace handoff
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * 会话级自适应抖动缓冲（按包驱动，本身无定时器）
+ *
+ * 设计原则：
+ * 1. 按序号重排：包放入 seq % kCapacity 槽位，按 next_seq 顺序吐出
+ * 2. 缓冲深度自适应：取 RFC 3550 到达抖动估计与近期最大乱序距离中的较大者，
+ *    只保留吸收乱序所需的最小延迟；乱序消失后深度逐步回落
+ * 3. 已越过播放点的包计为 late drop；队头缺包且缓冲已超深度时，吐出一个 lost 标记，
+ *    由调用方决定如何补帧
+ * 4. 槽位存储复用，稳态不分配内存
+ * 5. 对端停发后没有后续包推动出队，由调用方周期性调用 drain()：
+ *    超过缓冲深度对应的播放时长仍无新包，就按序吐出剩余帧
+ */
+class JitterBuffer {
+public:
+    static constexpr int kCapacity = 64;   // 序号窗口（10ms 包约 640ms）
+
+    struct Config {
+        int   min_depth     = 0;      // 最少缓冲包数，0 = 无乱序时直通
+        int   max_depth     = 48;
+        float jitter_factor = 2.0f;   // 深度 ≥ jitter_factor × 抖动
+    };
+
+    enum class PushResult {
+        kQueued,
+        kLate,        // 已越过播放点，丢弃
+        kDuplicate,
+        kReset        // 序号跳变过大，缓冲已清空重建
+    };
+
+    struct Frame {
+        bool           lost = false;
+        uint16_t       seq  = 0;
+        uint32_t       ts   = 0;
+        const uint8_t* data = nullptr;   // 有效期到下一次 push 为止
+        size_t         len  = 0;
+    };
+
+    struct Counters {
+        uint64_t late_drops = 0;
+        uint64_t duplicates = 0;
+        uint64_t lost       = 0;
+        uint64_t resets     = 0;
+    };
+
+    JitterBuffer() : JitterBuffer(Config{}) {}
+
+    explicit JitterBuffer(const Config& config)
+        : config_(config),
+          target_depth_(config.min_depth)
+    {}
+
+    /**
+     * @param arrival_us  到达时刻（单调时钟，微秒）
+     * @param ts          媒体时间戳（16 kHz 采样点）
+     */
+    PushResult push(uint16_t seq, uint32_t ts,
+                    const uint8_t* data, size_t len,
+                    int64_t arrival_us)
+    {
+        PushResult result = PushResult::kQueued;
+
+        if (!started_) {
+            reset(seq);
+        }
+        last_arrival_us_ = arrival_us;
+
+        int ahead = int16_t(uint16_t(seq - next_seq_));
+
+        if (ahead < 0) {
+            // 比播放点还旧：说明当前深度不够吸收这次乱序，立即放大
+            reorder_peak_ = std::max(reorder_peak_, int16_t(uint16_t(max_seq_ - seq)) + 1);
+            in_order_run_ = 0;
+            update_target();
+
+            if (++consecutive_late_ < kResetAfterLate) {
+                ++counters_.late_drops;
+                return PushResult::kLate;
+            }
+            // 连续迟到：对端序号重新开始
+            reset(seq);
+            result = PushResult::kReset;
+        } else if (ahead >= kCapacity) {
+            reset(seq);
+            result = PushResult::kReset;
+        }
+        consecutive_late_ = 0;
+
+        Slot& sl = slots_[seq % kCapacity];
+        if (sl.filled && sl.seq == seq) {
+            ++counters_.duplicates;
+            return PushResult::kDuplicate;
+        }
+
+        sl.payload.assign(data, data + len);
+        sl.seq    = seq;
+        sl.ts     = ts;
+        sl.filled = true;
+        ++buffered_;
+
+        int forward = int16_t(uint16_t(seq - max_seq_));
+        if (forward > 0) {
+            if (forward == 1 && max_ts_valid_ && ts != max_ts_) {
+                frame_us_ = std::clamp(
+                    (ts - max_ts_) * kUsPerSample, kMinFrameUs, kMaxFrameUs);
+            }
+            max_seq_ = seq;
+            max_ts_  = ts;
+            max_ts_valid_ = true;
+
+            // 乱序峰值缓慢衰减，让深度在链路变好后回落
+            if (reorder_peak_ > 0 && ++in_order_run_ >= kDecayPackets) {
+                --reorder_peak_;
+                in_order_run_ = 0;
+            }
+        } else if (forward < 0) {
+            reorder_peak_ = std::max(reorder_peak_, -forward);
+            in_order_run_ = 0;
+        }
+
+        update_jitter(ts, arrival_us);
+        update_target();
+        return result;
+    }
+
+    /**
+     * @brief 按序取出下一帧；缓冲未超过目标深度时返回 false
+     */
+    bool pop(Frame& out) {
+        if (!started_) return false;
+
+        int span = int16_t(uint16_t(max_seq_ - next_seq_)) + 1;
+        if (span <= target_depth_ || span <= 0) return false;
+
+        take(out);
+        return true;
+    }
+
+    /**
+     * @brief 对端停发后的排空：距最后一次到达已超过 (深度 + 1) 帧的时长仍无新包时，
+     *        不再等待，按序取出剩余帧（中间缺包照样吐 lost 标记）；无帧可取时返回 false
+     *
+     * 进程热交接恢复后尚无到达时刻，以第一次调用的时刻起算。
+     */
+    bool drain(Frame& out, int64_t now_us) {
+        if (!started_ || buffered_ == 0) return false;
+        if (last_arrival_us_ == 0) {
+            last_arrival_us_ = now_us;
+            return false;
+        }
+        if (double(now_us - last_arrival_us_) < (target_depth_ + 1) * frame_us_) return false;
+
+        take(out);
+        return true;
+    }
+
+    /**
+     * @brief 查看某序号是否已到达（不出队），供丢包时取下一包做 FEC
+     */
+    bool peek(uint16_t seq, const uint8_t*& data, size_t& len) const {
+        const Slot& sl = slots_[seq % kCapacity];
+        if (!sl.filled || sl.seq != seq) return false;
+        data = sl.payload.data();
+        len  = sl.payload.size();
+        return true;
+    }
+
+    /**
+     * @brief 回到初始状态（会话回收复用时调用），保留各槽位已分配的存储
+     */
+    void clear() {
+        for (auto& sl : slots_) sl.filled = false;
+        started_       = false;
+        next_seq_      = 0;
+        max_seq_       = 0;
+        max_ts_        = 0;
+        max_ts_valid_  = false;
+        buffered_      = 0;
+        last_arrival_us_ = 0;
+        frame_us_      = 10000.0;
+        jitter_us_     = 0.0;
+        last_transit_  = 0.0;
+        have_transit_  = false;
+        reorder_peak_  = 0;
+        in_order_run_  = 0;
+        consecutive_late_ = 0;
+        target_depth_  = config_.min_depth;
+        counters_      = Counters{};
+    }
+
+    /**
+     * @brief 导出 / 导入完整状态（进程热交接用）
+     *
+     * W 需提供 put(pod) / blob(p, n)，R 需提供 get(pod) / bytes(p, n) / ok()；
+     * 配置不随状态迁移，以导入方自己的配置为准。
+     */
+    template <class W>
+    void save(W& w) const {
+        w.put(started_);
+        w.put(next_seq_);
+        w.put(max_seq_);
+        w.put(max_ts_);
+        w.put(max_ts_valid_);
+        w.put(frame_us_);
+        w.put(jitter_us_);
+        w.put(last_transit_);
+        w.put(have_transit_);
+        w.put(reorder_peak_);
+        w.put(in_order_run_);
+        w.put(consecutive_late_);
+        w.put(counters_);
+
+        w.put(uint32_t(buffered_));
+        for (const auto& sl : slots_) {
+            if (!sl.filled) continue;
+            w.put(sl.seq);
+            w.put(sl.ts);
+            w.blob(sl.payload.data(), sl.payload.size());
+        }
+    }
+
+    template <class R>
+    bool restore(R& r) {
+        clear();
+        r.get(started_);
+        r.get(next_seq_);
+        r.get(max_seq_);
+        r.get(max_ts_);
+        r.get(max_ts_valid_);
+        r.get(frame_us_);
+        r.get(jitter_us_);
+        r.get(last_transit_);
+        r.get(have_transit_);
+        r.get(reorder_peak_);
+        r.get(in_order_run_);
+        r.get(consecutive_late_);
+        r.get(counters_);
+
+        uint32_t n = 0;
+        r.get(n);
+        for (uint32_t i = 0; i < n && i < uint32_t(kCapacity) && r.ok(); ++i) {
+            uint16_t seq = 0;
+            uint32_t ts = 0, len = 0;
+            r.get(seq);
+            r.get(ts);
+            r.get(len);
+
+            Slot& sl = slots_[seq % kCapacity];
+            sl.payload.resize(len);
+            if (!r.bytes(sl.payload.data(), len)) break;
+            sl.seq    = seq;
+            sl.ts     = ts;
+            sl.filled = true;
+            ++buffered_;
+        }
+
+        if (!r.ok()) {
+            clear();
+            return false;
+        }
+        update_target();
+        return true;
+    }
+
+    int depth() const { return target_depth_; }
+    int buffered() const { return buffered_; }
+    float jitter_ms() const { return jitter_us_ / 1000.0f; }
+    const Counters& counters() const { return counters_; }
+
+private:
+    static constexpr int    kResetAfterLate = 50;
+    static constexpr int    kDecayPackets   = 200;
+    static constexpr double kUsPerSample    = 1e6 / 16000.0;
+    static constexpr double kMinFrameUs     = 2500.0;     // Opus 最短帧
+    static constexpr double kMaxFrameUs     = 120000.0;   // Opus 最长包
+
+    struct Slot {
+        std::vector<uint8_t> payload;
+        uint32_t ts     = 0;
+        uint16_t seq    = 0;
+        bool     filled = false;
+    };
+
+    // 取出 next_seq_ 对应的帧（未到达则为 lost 标记）并推进播放点
+    void take(Frame& out) {
+        Slot& sl = slots_[next_seq_ % kCapacity];
+        if (sl.filled && sl.seq == next_seq_) {
+            out.lost = false;
+            out.seq  = sl.seq;
+            out.ts   = sl.ts;
+            out.data = sl.payload.data();
+            out.len  = sl.payload.size();
+            sl.filled = false;
+            --buffered_;
+        } else {
+            out = Frame{};
+            out.lost = true;
+            out.seq  = next_seq_;
+            ++counters_.lost;
+        }
+
+        ++next_seq_;
+    }
+
+    void reset(uint16_t seq) {
+        if (started_) {
+            ++counters_.resets;
+        }
+        for (auto& sl : slots_) sl.filled = false;
+        buffered_  = 0;
+        next_seq_  = seq;
+        max_seq_   = uint16_t(seq - 1);
+        max_ts_valid_ = false;
+        have_transit_ = false;
+        started_   = true;
+    }
+
+    // RFC 3550 到达间隔抖动：J += (|D| - J) / 16
+    void update_jitter(uint32_t ts, int64_t arrival_us) {
+        double transit = double(arrival_us) - double(ts) * kUsPerSample;
+        if (have_transit_) {
+            double d = std::fabs(transit - last_transit_);
+            // 时间戳回绕 / 跳变时不计入
+            if (d < 5e6) {
+                jitter_us_ += (d - jitter_us_) / 16.0;
+            }
+        }
+        last_transit_ = transit;
+        have_transit_ = true;
+    }
+
+    void update_target() {
+        int by_jitter =
+            int(std::ceil(config_.jitter_factor * jitter_us_ / std::max(frame_us_, 1.0)));
+        target_depth_ = std::clamp(
+            std::max(by_jitter, reorder_peak_), config_.min_depth, config_.max_depth);
+    }
+
+    Config config_;
+    Slot   slots_[kCapacity];
+
+    bool     started_  = false;
+    uint16_t next_seq_ = 0;
+    uint16_t max_seq_  = 0;
+    uint32_t max_ts_   = 0;
+    bool     max_ts_valid_ = false;
+    int      buffered_ = 0;
+    int64_t  last_arrival_us_ = 0;
+
+    double frame_us_      = 10000.0;
+    double jitter_us_     = 0.0;
+    double last_transit_  = 0.0;
+    bool   have_transit_  = false;
+
+    int reorder_peak_     = 0;
+    int in_order_run_     = 0;
+    int consecutive_late_ = 0;
+    int target_depth_     = 0;
+
+    Counters counters_;
+};
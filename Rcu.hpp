@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * 基于 epoch 的 RCU：读多写极少的共享对象（运行时配置等）
+ *
+ * 设计原则：
+ * 1. 读端无锁：进入读区时把全局 epoch 写进本线程槽位，退出时置为空闲；
+ *    同一线程可嵌套，只有最外层真正登记 / 注销
+ * 2. 写端整体替换指针，旧对象连同替换时的 epoch 挂入退休列表；
+ *    所有槽位都空闲或已进入更新的 epoch 后，才可能没有读者再持有旧对象，此时释放
+ * 3. 槽位按线程首次读取时分配，超出 kMaxReaders 的线程退化为共用一个计数器，
+ *    只会让回收更保守，不影响正确性
+ *
+ * 用法：
+ *   rcu::Cell<Config> g_cfg{std::make_unique<Config>()};
+ *   { auto cfg = g_cfg.read(); use(cfg->x); }      // 读
+ *   g_cfg.publish(std::make_unique<Config>(...));   // 写（可在任意线程）
+ *   g_cfg.reclaim();                                // 周期性回收
+ */
+namespace rcu {
+
+static constexpr int      kMaxReaders = 1024;
+static constexpr uint64_t kIdle       = UINT64_MAX;
+
+class Domain {
+public:
+    void enter() {
+        if (t_depth_++ > 0) return;
+
+        if (t_slot_ == kUnassigned) {
+            int i = used_.fetch_add(1, std::memory_order_relaxed);
+            t_slot_ = (i < kMaxReaders) ? i : kOverflow;
+        }
+
+        if (t_slot_ == kOverflow) {
+            overflow_.fetch_add(1, std::memory_order_seq_cst);
+        } else {
+            // acquire：读到新 epoch 就一定能看到推进 epoch 之前替换的指针
+            slots_[t_slot_].epoch.store(epoch_.load(std::memory_order_acquire),
+                                        std::memory_order_relaxed);
+        }
+        // 登记必须先于随后对共享指针的读取对写端可见
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void leave() {
+        if (--t_depth_ > 0) return;
+
+        if (t_slot_ == kOverflow) {
+            overflow_.fetch_sub(1, std::memory_order_release);
+        } else {
+            slots_[t_slot_].epoch.store(kIdle, std::memory_order_release);
+        }
+    }
+
+    // 写端：替换指针之后调用，返回旧对象的退休 epoch
+    uint64_t advance() {
+        return epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    }
+
+    // 是否已没有读者停留在 retired 之前的 epoch
+    bool quiescent(uint64_t retired) const {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (overflow_.load(std::memory_order_acquire) != 0) return false;
+
+        int n = std::min(used_.load(std::memory_order_acquire), kMaxReaders);
+        for (int i = 0; i < n; ++i) {
+            if (slots_[i].epoch.load(std::memory_order_acquire) < retired) return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kUnassigned = -1;
+    static constexpr int kOverflow   = -2;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{kIdle};
+    };
+
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<int>      used_{0};
+    std::atomic<int>      overflow_{0};
+    Slot slots_[kMaxReaders];
+
+    static inline thread_local int t_slot_  = kUnassigned;
+    static inline thread_local int t_depth_ = 0;
+};
+
+inline Domain g_domain;
+
+template <class T>
+class Cell {
+public:
+    explicit Cell(std::unique_ptr<T> init) : ptr_(init.release()) {}
+
+    ~Cell() {
+        delete ptr_.load(std::memory_order_relaxed);
+        for (auto& r : retired_) delete r.first;
+    }
+
+    Cell(const Cell&) = delete;
+    Cell& operator=(const Cell&) = delete;
+
+    // 读区守卫：存活期间拿到的对象不会被释放
+    class Reader {
+    public:
+        explicit Reader(const Cell& c) {
+            g_domain.enter();
+            p_ = c.ptr_.load(std::memory_order_acquire);
+        }
+        ~Reader() { g_domain.leave(); }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const T& operator*() const { return *p_; }
+        const T* operator->() const { return p_; }
+
+    private:
+        const T* p_;
+    };
+
+    Reader read() const { return Reader(*this); }
+
+    void publish(std::unique_ptr<T> next) {
+        std::lock_guard<std::mutex> lk(mu_);
+        T* old = ptr_.exchange(next.release(), std::memory_order_seq_cst);
+        retired_.emplace_back(old, g_domain.advance());
+    }
+
+    // 释放已无读者的旧对象，返回仍在等待的个数
+    size_t reclaim() {
+        std::lock_guard<std::mutex> lk(mu_);
+        size_t kept = 0;
+        for (auto& r : retired_) {
+            if (g_domain.quiescent(r.second)) {
+                delete r.first;
+            } else {
+                retired_[kept++] = r;
+            }
+        }
+        retired_.resize(kept);
+        return kept;
+    }
+
+private:
+    std::atomic<T*> ptr_;
+
+    std::mutex mu_;   // 只串行化写端
+    std::vector<std::pair<T*, uint64_t>> retired_;
+};
+
+}  // namespace rcu
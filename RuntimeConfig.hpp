@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+/**
+ * 可热加载的运行时配置（-C 指定文件，SIGHUP 重新加载）
+ *
+ * 设计原则：
+ * 1. 文件格式为每行 key = value，# 之后为注释；文件里没写的键取内置默认值，
+ *    因此删掉一行等于恢复默认
+ * 2. 任何一行出错（未知键、数值越界、地址无法解析）整个文件作废，继续使用旧配置
+ * 3. 对象加载后只读，通过 rcu::Cell 整体替换；version 每次加载递增，
+ *    会话在帧边界比较版本号决定是否重新套用（VAD 模式、APM 开关）
+ */
+struct RuntimeConfig {
+    static constexpr int kMaxSttChunkMs = 200;
+    static constexpr int kMaxPrerollMs  = 300;
+
+    uint64_t version = 1;
+
+    // 静音判停：连续多少次“非语音”判定后发送 end
+    int webrtc_silence_frames  = 50;   // WebRTC VAD 每 10ms 帧判定一次
+    int silero_silence_windows = 30;   // Silero 每 40ms 窗口判定一次
+    int tenvad_silence_frames  = 30;   // TenVAD 每 10ms 帧判定一次
+
+    // start 之后补发的起始前音频（ms，10 的倍数）：判定越滞后的引擎需要越长
+    int preroll_silero_ms = 60;        // Silero 攒满 512 样本窗才判定
+    int preroll_webrtc_ms = 20;
+    int preroll_tenvad_ms = 20;
+
+    float silero_threshold = 0.5f;
+    float tenvad_threshold = 0.5f;
+    int   webrtc_vad_mode  = 3;        // 0..3，越大越严格
+
+    int udp_timeout_sec    = 30;
+    int speech_timeout_sec = 120;
+
+    bool apm_aec      = true;
+    bool apm_ns       = true;
+    int  apm_ns_level = 1;             // 0 low / 1 moderate / 2 high / 3 very high
+
+    std::string stt_host = "127.0.0.1";
+    int         stt_port = 9000;
+    int         stt_chunk_ms = 10;     // 发往 STT 的 PCM 块长，10 = 每帧一发（不聚合）
+    sockaddr_in stt_addr{};            // 由 stt_host / stt_port 解析
+
+    // STT 出口编码：pcm 原样发送；opus 用会话自有编码器重新压缩（跨机房 STT 省带宽），
+    // 此时 stt_chunk_ms 不生效，每个 Opus 帧一个报文。新取值从下一段语音开始生效
+    bool stt_opus            = false;
+    int  stt_opus_bitrate    = 24000;  // bit/s
+    int  stt_opus_frame_ms   = 20;     // 10 / 20 / 40 / 60
+    int  stt_opus_complexity = 5;      // 0..10，越大音质越好、越费 CPU
+
+    // 根据 stt_host / stt_port 填 stt_addr
+    bool resolve() {
+        stt_addr = sockaddr_in{};
+        stt_addr.sin_family = AF_INET;
+        stt_addr.sin_port   = htons(uint16_t(stt_port));
+        return inet_pton(AF_INET, stt_host.c_str(), &stt_addr.sin_addr) == 1;
+    }
+
+    static RuntimeConfig defaults() {
+        RuntimeConfig c;
+        c.resolve();
+        return c;
+    }
+
+    /**
+     * @brief 从文件加载；失败时 out 不变，err 为带行号的原因
+     */
+    static bool load(const std::string& path, RuntimeConfig& out, std::string& err) {
+        std::ifstream f(path);
+        if (!f) {
+            err = "cannot open " + path;
+            return false;
+        }
+
+        RuntimeConfig c;
+        std::string line;
+        int lineno = 0;
+
+        while (std::getline(f, line)) {
+            ++lineno;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+
+            size_t eq = line.find('=');
+            std::string key = trim(line.substr(0, eq));
+            if (key.empty()) continue;
+            if (eq == std::string::npos) {
+                err = path + ":" + std::to_string(lineno) + ": expected key = value";
+                return false;
+            }
+            std::string val = trim(line.substr(eq + 1));
+
+            if (!c.set(key, val)) {
+                err = path + ":" + std::to_string(lineno) + ": invalid " + key + " = " + val;
+                return false;
+            }
+        }
+
+        if (!c.resolve()) {
+            err = path + ": stt_host is not an IPv4 address: " + c.stt_host;
+            return false;
+        }
+        out = c;
+        return true;
+    }
+
+private:
+    static std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        if (b == std::string::npos) return {};
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return s.substr(b, e - b + 1);
+    }
+
+    static bool to_int(const std::string& v, int lo, int hi, int& out) {
+        char* end = nullptr;
+        long x = std::strtol(v.c_str(), &end, 10);
+        if (v.empty() || *end != '\0' || x < lo || x > hi) return false;
+        out = int(x);
+        return true;
+    }
+
+    // 以 10ms 帧为单位的时长
+    static bool to_ms(const std::string& v, int hi, int& out) {
+        return to_int(v, 0, hi, out) && out % 10 == 0;
+    }
+
+    static bool to_float(const std::string& v, float lo, float hi, float& out) {
+        char* end = nullptr;
+        float x = std::strtof(v.c_str(), &end);
+        if (v.empty() || *end != '\0' || !(x >= lo && x <= hi)) return false;
+        out = x;
+        return true;
+    }
+
+    static bool to_bool(const std::string& v, bool& out) {
+        if (v == "1" || v == "true" || v == "on")   { out = true;  return true; }
+        if (v == "0" || v == "false" || v == "off") { out = false; return true; }
+        return false;
+    }
+
+    bool set(const std::string& k, const std::string& v) {
+        if (k == "webrtc_silence_frames")  return to_int(v, 1, 10000, webrtc_silence_frames);
+        if (k == "silero_silence_windows") return to_int(v, 1, 10000, silero_silence_windows);
+        if (k == "tenvad_silence_frames")  return to_int(v, 1, 10000, tenvad_silence_frames);
+        if (k == "preroll_silero_ms")      return to_ms(v, kMaxPrerollMs, preroll_silero_ms);
+        if (k == "preroll_webrtc_ms")      return to_ms(v, kMaxPrerollMs, preroll_webrtc_ms);
+        if (k == "preroll_tenvad_ms")      return to_ms(v, kMaxPrerollMs, preroll_tenvad_ms);
+        if (k == "silero_threshold")       return to_float(v, 0.0f, 1.0f, silero_threshold);
+        if (k == "tenvad_threshold")       return to_float(v, 0.0f, 1.0f, tenvad_threshold);
+        if (k == "webrtc_vad_mode")        return to_int(v, 0, 3, webrtc_vad_mode);
+        if (k == "udp_timeout_sec")        return to_int(v, 1, 86400, udp_timeout_sec);
+        if (k == "speech_timeout_sec")     return to_int(v, 1, 86400, speech_timeout_sec);
+        if (k == "apm_aec")                return to_bool(v, apm_aec);
+        if (k == "apm_ns")                 return to_bool(v, apm_ns);
+        if (k == "apm_ns_level")           return to_int(v, 0, 3, apm_ns_level);
+        if (k == "stt_port")               return to_int(v, 1, 65535, stt_port);
+        if (k == "stt_chunk_ms")
+            return to_ms(v, kMaxSttChunkMs, stt_chunk_ms) && stt_chunk_ms >= 10;
+        if (k == "stt_codec") {
+            if (v == "pcm")  { stt_opus = false; return true; }
+            if (v == "opus") { stt_opus = true;  return true; }
+            return false;
+        }
+        if (k == "stt_opus_bitrate")       return to_int(v, 6000, 128000, stt_opus_bitrate);
+        if (k == "stt_opus_frame_ms")
+            return to_int(v, 10, 60, stt_opus_frame_ms) &&
+                   (stt_opus_frame_ms == 10 || stt_opus_frame_ms == 20 ||
+                    stt_opus_frame_ms == 40 || stt_opus_frame_ms == 60);
+        if (k == "stt_opus_complexity")    return to_int(v, 0, 10, stt_opus_complexity);
+        if (k == "stt_host") {
+            stt_host = v;
+            return !v.empty();
+        }
+        return false;
+    }
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/**
+ * UDP 批量发送（每个线程一个实例，单线程使用）
+ *
+ * 设计原则：
+ * 1. stage() 把 [前缀][负载] 拷进预分配的连续缓冲区并记下目的地址，不进内核；
+ *    flush() 用一次 sendmmsg 发出全部暂存报文
+ * 2. 一批报文必须走同一个 fd：fd 变化、缓冲区或槽位用完、最早一条暂存超过
+ *    max_delay_us 时，stage() 先把已有的发出去
+ * 3. 没有定时器：暂存时长只在 stage() / flush_if_due() 被调用时检查，
+ *    调用方需在每个处理单元（一帧 / 一个任务）之后调一次 flush_if_due()，空闲时 flush()
+ * 4. 单条超过缓冲区容量的报文不暂存，直接 sendmsg（保持顺序：先 flush）
+ * 5. 和原来的逐包 sendmsg 一样不重试：某条发送失败就跳过它，继续发后面的
+ */
+class SendBatch {
+public:
+    struct Config {
+        int     max_msgs     = 64;
+        size_t  buffer_bytes = 64 * 1024;
+        int64_t max_delay_us = 1000;
+    };
+
+    // 单写者计数：本线程写，统计线程读
+    struct Stats {
+        std::atomic<uint64_t> msgs{0};       // 发出的报文数
+        std::atomic<uint64_t> syscalls{0};   // sendmmsg / sendmsg 调用次数
+    };
+
+    explicit SendBatch(const Config& config)
+        : config_(config),
+          buf_(new uint8_t[config.buffer_bytes]),
+          addrs_(config.max_msgs),
+          iovs_(config.max_msgs),
+          msgs_(config.max_msgs)
+    {
+        for (int i = 0; i < config_.max_msgs; ++i) {
+            msgs_[i] = {};
+            msgs_[i].msg_hdr.msg_name    = &addrs_[i];
+            msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            msgs_[i].msg_hdr.msg_iov     = &iovs_[i];
+            msgs_[i].msg_hdr.msg_iovlen  = 1;
+        }
+    }
+
+    SendBatch(const SendBatch&) = delete;
+    SendBatch& operator=(const SendBatch&) = delete;
+
+    /**
+     * @param now_us  调用方的单调时钟（微秒），用于最长暂存时间判断
+     */
+    void stage(int fd, const sockaddr_in& to,
+               const void* prefix, size_t prefix_len,
+               const void* data, size_t len,
+               int64_t now_us)
+    {
+        size_t total = prefix_len + len;
+
+        if (count_ > 0 &&
+            (fd != fd_ || count_ == config_.max_msgs ||
+             used_ + total > config_.buffer_bytes ||
+             now_us - first_us_ >= config_.max_delay_us)) {
+            flush();
+        }
+
+        if (total > config_.buffer_bytes) {
+            send_one(fd, to, prefix, prefix_len, data, len);
+            return;
+        }
+
+        if (count_ == 0) {
+            fd_ = fd;
+            first_us_ = now_us;
+        }
+
+        uint8_t* p = buf_.get() + used_;
+        std::memcpy(p, prefix, prefix_len);
+        std::memcpy(p + prefix_len, data, len);
+        used_ += total;
+
+        addrs_[count_] = to;
+        iovs_[count_].iov_base = p;
+        iovs_[count_].iov_len  = total;
+        ++count_;
+    }
+
+    void flush() {
+        int off = 0;
+        while (off < count_) {
+            int r = sendmmsg(fd_, msgs_.data() + off, unsigned(count_ - off), 0);
+            bump(stats_.syscalls);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                ++off;   // 跳过发送失败的这一条
+                continue;
+            }
+            off += r;
+        }
+        bump(stats_.msgs, uint64_t(count_));
+        count_ = 0;
+        used_  = 0;
+    }
+
+    // 最早一条暂存已满 max_delay_us 时发出整批
+    void flush_if_due(int64_t now_us) {
+        if (count_ > 0 && now_us - first_us_ >= config_.max_delay_us) flush();
+    }
+
+    int pending() const { return count_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    void send_one(int fd, const sockaddr_in& to,
+                  const void* prefix, size_t prefix_len,
+                  const void* data, size_t len)
+    {
+        iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(prefix);
+        iov[0].iov_len  = prefix_len;
+        iov[1].iov_base = const_cast<void*>(data);
+        iov[1].iov_len  = len;
+
+        msghdr msg{};
+        msg.msg_name    = const_cast<sockaddr_in*>(&to);
+        msg.msg_namelen = sizeof(to);
+        msg.msg_iov     = iov;
+        msg.msg_iovlen  = 2;
+
+        sendmsg(fd, &msg, 0);
+        bump(stats_.syscalls);
+        bump(stats_.msgs);
+    }
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t d = 1) {
+        c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+
+    Config config_;
+    std::unique_ptr<uint8_t[]> buf_;
+    std::vector<sockaddr_in> addrs_;
+    std::vector<iovec>       iovs_;
+    std::vector<mmsghdr>     msgs_;
+
+    int     fd_       = -1;
+    int     count_    = 0;
+    size_t  used_     = 0;
+    int64_t first_us_ = 0;
+
+    Stats stats_;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/random.h>
+
+/**
+ * 128 位二进制会话 ID
+ *
+ * 设计原则：
+ * 1. 会话内部、g_id_map、STT / AI 报文前缀一律用 16 字节二进制形式，只有日志才转 hex
+ * 2. 由线程私有 ChaCha20 CSPRNG 生成：每线程首次使用时用 getrandom() 取 256 位密钥，
+ *    之后每个 64 字节块产出 4 个 ID，无系统调用、无锁、无堆分配
+ * 3. ID 本身已是均匀随机数，哈希直接取前 8 字节
+ */
+struct SessionId {
+    static constexpr size_t kSize    = 16;
+    static constexpr size_t kHexSize = 2 * kSize;
+
+    uint8_t bytes[kSize] = {};
+
+    bool operator==(const SessionId& o) const {
+        return std::memcmp(bytes, o.bytes, kSize) == 0;
+    }
+    bool operator!=(const SessionId& o) const { return !(*this == o); }
+
+    // out 至少 kHexSize + 1 字节，以 '\0' 结尾
+    void to_hex(char* out) const {
+        static const char* digits = "0123456789abcdef";
+        for (size_t i = 0; i < kSize; ++i) {
+            out[2 * i]     = digits[bytes[i] >> 4];
+            out[2 * i + 1] = digits[bytes[i] & 0xf];
+        }
+        out[kHexSize] = '\0';
+    }
+
+    // 解析 kHexSize 个 hex 字符；格式不对返回 false
+    static bool from_hex(const char* hex, SessionId& out) {
+        for (size_t i = 0; i < kSize; ++i) {
+            int hi = hex_value(hex[2 * i]);
+            int lo = hex_value(hex[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out.bytes[i] = uint8_t((hi << 4) | lo);
+        }
+        return true;
+    }
+
+    static SessionId from_bytes(const void* p) {
+        SessionId id;
+        std::memcpy(id.bytes, p, kSize);
+        return id;
+    }
+
+    static SessionId generate();
+
+private:
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+};
+
+struct SessionIdHash {
+    size_t operator()(const SessionId& id) const {
+        uint64_t h;
+        std::memcpy(&h, id.bytes, sizeof(h));
+        return size_t(h);
+    }
+};
+
+/**
+ * ChaCha20 块函数驱动的随机字节流（RFC 8439 的 20 轮核心，计数器 64 位）
+ */
+class ChaChaRng {
+public:
+    ChaChaRng() {
+        uint8_t seed[32];
+        size_t got = 0;
+        while (got < sizeof(seed)) {
+            ssize_t r = getrandom(seed + got, sizeof(seed) - got, 0);
+            if (r < 0) throw std::runtime_error("getrandom failed");
+            got += size_t(r);
+        }
+
+        state_[0] = 0x61707865;   // "expand 32-byte k"
+        state_[1] = 0x3320646e;
+        state_[2] = 0x79622d32;
+        state_[3] = 0x6b206574;
+        std::memcpy(&state_[4], seed, sizeof(seed));
+        state_[12] = state_[13] = state_[14] = state_[15] = 0;
+        std::memset(seed, 0, sizeof(seed));
+    }
+
+    void fill(uint8_t* out, size_t n) {
+        while (n > 0) {
+            if (pos_ == sizeof(block_)) refill();
+            size_t take = sizeof(block_) - pos_;
+            if (take > n) take = n;
+            std::memcpy(out, block_ + pos_, take);
+            std::memset(block_ + pos_, 0, take);   // 用过的密钥流不留在内存里
+            pos_ += take;
+            out  += take;
+            n    -= take;
+        }
+    }
+
+private:
+    static uint32_t rotl(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
+
+    static void quarter(uint32_t* x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+    }
+
+    void refill() {
+        uint32_t x[16];
+        std::memcpy(x, state_, sizeof(x));
+        for (int i = 0; i < 10; ++i) {
+            quarter(x, 0, 4,  8, 12);
+            quarter(x, 1, 5,  9, 13);
+            quarter(x, 2, 6, 10, 14);
+            quarter(x, 3, 7, 11, 15);
+            quarter(x, 0, 5, 10, 15);
+            quarter(x, 1, 6, 11, 12);
+            quarter(x, 2, 7,  8, 13);
+            quarter(x, 3, 4,  9, 14);
+        }
+        for (int i = 0; i < 16; ++i) {
+            uint32_t v = x[i] + state_[i];
+            std::memcpy(block_ + 4 * i, &v, 4);
+        }
+
+        if (++state_[12] == 0) ++state_[13];
+        pos_ = 0;
+    }
+
+    uint32_t state_[16];
+    uint8_t  block_[64] = {};
+    size_t   pos_ = sizeof(block_);
+};
+
+inline SessionId SessionId::generate() {
+    thread_local ChaChaRng rng;
+    SessionId id;
+    rng.fill(id.bytes, kSize);
+    return id;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/**
+ * 会话 key：客户端 IP + 端口的紧凑二进制形式
+ *
+ * IPv4 以 v4-mapped IPv6（::ffff:a.b.c.d）形式存放，两种地址族共用一套比较 / 哈希。
+ * 只在打日志时才转成字符串。
+ */
+struct SessionKey {
+    uint8_t  addr[16] = {};
+    uint16_t port     = 0;   // 网络字节序，原样保留
+
+    static SessionKey from(const sockaddr_in& a) {
+        SessionKey k;
+        k.addr[10] = 0xff;
+        k.addr[11] = 0xff;
+        std::memcpy(k.addr + 12, &a.sin_addr, 4);
+        k.port = a.sin_port;
+        return k;
+    }
+
+    static SessionKey from(const sockaddr_in6& a) {
+        SessionKey k;
+        std::memcpy(k.addr, &a.sin6_addr, 16);
+        k.port = a.sin6_port;
+        return k;
+    }
+
+    bool operator==(const SessionKey& o) const {
+        return port == o.port && std::memcmp(addr, o.addr, 16) == 0;
+    }
+
+    uint64_t hash() const {
+        uint64_t hi, lo;
+        std::memcpy(&hi, addr, 8);
+        std::memcpy(&lo, addr + 8, 8);
+
+        // murmur3 fmix64 混合，保证低位分布均匀（表大小是 2 的幂）
+        uint64_t h = hi * 0x9e3779b97f4a7c15ULL ^ lo ^ (uint64_t(port) << 48);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // 仅用于日志
+    std::string to_string() const {
+        static const uint8_t kV4Prefix[12] =
+            {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+        char ip[INET6_ADDRSTRLEN];
+        if (std::memcmp(addr, kV4Prefix, 12) == 0) {
+            inet_ntop(AF_INET, addr + 12, ip, sizeof(ip));
+            return std::string(ip) + ":" + std::to_string(ntohs(port));
+        }
+        inet_ntop(AF_INET6, addr, ip, sizeof(ip));
+        return "[" + std::string(ip) + "]:" + std::to_string(ntohs(port));
+    }
+};
+
+/**
+ * 开放寻址会话表（线性探测 + 回移删除，无墓碑）
+ *
+ * 设计原则：
+ * 1. 查找不做任何堆分配，只在扩容时分配
+ * 2. 哈希值单独成数组，探测时先比 32 位哈希，命中后才比完整 key，探测序列集中在少数 cache line
+ * 3. 单线程使用（每个 worker 一张表），不加锁
+ */
+template <class V>
+class FlatSessionTable {
+public:
+    explicit FlatSessionTable(size_t initial_capacity = 1024) {
+        rehash(round_up(initial_capacity));
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return tags_.size(); }
+
+    V* find(const SessionKey& key) {
+        uint32_t tag = make_tag(key.hash());
+        for (size_t i = tag & mask_;; i = (i + 1) & mask_) {
+            if (tags_[i] == 0) return nullptr;
+            if (tags_[i] == tag && slots_[i].key == key) return &slots_[i].value;
+        }
+    }
+
+    /**
+     * @brief 插入或取得已有项
+     * @return {值指针, 是否新插入}
+     */
+    std::pair<V*, bool> try_emplace(const SessionKey& key) {
+        if ((size_ + 1) * 4 > capacity() * 3) {
+            rehash(capacity() * 2);
+        }
+
+        uint32_t tag = make_tag(key.hash());
+        size_t i = tag & mask_;
+        for (;; i = (i + 1) & mask_) {
+            if (tags_[i] == 0) break;
+            if (tags_[i] == tag && slots_[i].key == key) return {&slots_[i].value, false};
+        }
+
+        tags_[i] = tag;
+        slots_[i].key = key;
+        slots_[i].value = V{};
+        ++size_;
+        return {&slots_[i].value, true};
+    }
+
+    bool erase(const SessionKey& key) {
+        uint32_t tag = make_tag(key.hash());
+        for (size_t i = tag & mask_;; i = (i + 1) & mask_) {
+            if (tags_[i] == 0) return false;
+            if (tags_[i] == tag && slots_[i].key == key) {
+                erase_at(i);
+                return true;
+            }
+        }
+    }
+
+    template <class F>
+    void for_each(F&& f) {
+        for (size_t i = 0; i < tags_.size(); ++i) {
+            if (tags_[i] != 0) f(slots_[i].key, slots_[i].value);
+        }
+    }
+
+private:
+    struct Slot {
+        SessionKey key;
+        V          value{};
+    };
+
+    // 0 保留为“空槽”
+    static uint32_t make_tag(uint64_t h) {
+        uint32_t t = uint32_t(h ^ (h >> 32));
+        return t ? t : 1;
+    }
+
+    static size_t round_up(size_t n) {
+        size_t c = 16;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    void erase_at(size_t i) {
+        tags_[i] = 0;
+        slots_[i].value = V{};
+        --size_;
+
+        // 回移：把后续簇中“可以前移”的项填进空洞，保持探测链连续
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask_; tags_[j] != 0; j = (j + 1) & mask_) {
+            size_t home = tags_[j] & mask_;
+            bool movable = (hole <= j) ? (home <= hole || home > j)
+                                       : (home <= hole && home > j);
+            if (movable) {
+                tags_[hole]  = tags_[j];
+                slots_[hole] = std::move(slots_[j]);
+                tags_[j]     = 0;
+                slots_[j].value = V{};
+                hole = j;
+            }
+        }
+    }
+
+    void rehash(size_t new_cap) {
+        std::vector<uint32_t> old_tags;
+        std::vector<Slot>     old_slots;
+        old_tags.swap(tags_);
+        old_slots.swap(slots_);
+
+        tags_.assign(new_cap, 0);
+        slots_.resize(new_cap);
+        mask_ = new_cap - 1;
+
+        for (size_t i = 0; i < old_tags.size(); ++i) {
+            if (old_tags[i] == 0) continue;
+            size_t j = old_tags[i] & mask_;
+            while (tags_[j] != 0) j = (j + 1) & mask_;
+            tags_[j]  = old_tags[i];
+            slots_[j] = std::move(old_slots[i]);
+        }
+    }
+
+    std::vector<uint32_t> tags_;
+    std::vector<Slot>     slots_;
+    size_t                mask_ = 0;
+    size_t                size_ = 0;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SttShm.h"
+
+/**
+ * 共享内存 STT 环：网关侧（生产者）
+ *
+ * 设计原则：
+ * 1. 布局、提交协议见 SttShm.h；本类负责 memfd / eventfd 的创建、数据区双重映射与写入
+ * 2. write() 可被任意处理线程并发调用：CAS 预留、原地写记录、release 提交，无锁无 syscall；
+ *    只有消费者正阻塞等待时才 write(eventfd) 唤醒它
+ * 3. 空间不足时丢弃这一条并计数，不阻塞处理线程（实时路径不能等消费者）
+ * 4. 单条记录不超过 capacity / 4，大记录不会因为等不到连续空间而被反复丢弃
+ */
+class SttShmRing {
+public:
+    ~SttShmRing() {
+        if (base_) munmap(base_, STT_SHM_HEADER_BYTES + 2 * capacity_);
+        if (memfd_ >= 0) close(memfd_);
+        if (efd_ >= 0) close(efd_);
+    }
+
+    SttShmRing(const SttShmRing&) = delete;
+    SttShmRing& operator=(const SttShmRing&) = delete;
+
+    /**
+     * @param capacity  数据区字节数，须为 2 的幂且是页大小的整数倍
+     */
+    static std::unique_ptr<SttShmRing> create(size_t capacity, uint32_t sample_rate,
+                                              std::string& err) {
+        long page = sysconf(_SC_PAGESIZE);
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            capacity % size_t(page) != 0 || STT_SHM_HEADER_BYTES % size_t(page) != 0) {
+            err = "capacity must be a power of two and page aligned";
+            return nullptr;
+        }
+
+        std::unique_ptr<SttShmRing> r(new SttShmRing());
+        r->capacity_ = capacity;
+
+        r->memfd_ = memfd_create("aeroshell-stt", MFD_CLOEXEC);
+        if (r->memfd_ < 0 || ftruncate(r->memfd_, off_t(STT_SHM_HEADER_BYTES + capacity)) < 0) {
+            err = std::string("memfd: ") + strerror(errno);
+            return nullptr;
+        }
+        r->efd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (r->efd_ < 0) {
+            err = std::string("eventfd: ") + strerror(errno);
+            return nullptr;
+        }
+
+        // 先占一段连续地址，再把头和两份数据区 MAP_FIXED 进去
+        size_t span = STT_SHM_HEADER_BYTES + 2 * capacity;
+        void* base = mmap(nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            err = std::string("mmap: ") + strerror(errno);
+            return nullptr;
+        }
+        r->base_ = static_cast<uint8_t*>(base);
+
+        uint8_t* data = r->base_ + STT_SHM_HEADER_BYTES;
+        if (mmap(r->base_, STT_SHM_HEADER_BYTES + capacity, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, r->memfd_, 0) == MAP_FAILED ||
+            mmap(data + capacity, capacity, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, r->memfd_, off_t(STT_SHM_HEADER_BYTES)) == MAP_FAILED) {
+            err = std::string("mmap: ") + strerror(errno);
+            return nullptr;
+        }
+
+        r->hdr_  = reinterpret_cast<stt_shm_header*>(r->base_);
+        r->data_ = data;
+
+        r->hdr_->capacity    = capacity;
+        r->hdr_->sample_rate = sample_rate;
+        r->hdr_->id_bytes    = STT_SHM_ID_BYTES;
+        r->hdr_->version     = STT_SHM_VERSION;
+        __atomic_store_n(&r->hdr_->magic, STT_SHM_MAGIC, __ATOMIC_RELEASE);
+        return r;
+    }
+
+    /**
+     * @brief 写一条记录；环满或记录过大时丢弃并返回 false
+     * @param gen  本段语音锁定的消费者代号，写进记录头供消费者过滤
+     */
+    bool write(uint16_t type, uint32_t gen, const uint8_t* session_id,
+               const void* data, uint32_t len) {
+        uint32_t size = stt_shm_record_size(len);
+        if (size > capacity_ / 4) {
+            __atomic_fetch_add(&hdr_->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+
+        uint64_t pos = __atomic_load_n(&hdr_->reserve, __ATOMIC_RELAXED);
+        do {
+            uint64_t tail = __atomic_load_n(&hdr_->tail, __ATOMIC_ACQUIRE);
+            if (pos + size - tail > capacity_) {
+                __atomic_fetch_add(&hdr_->dropped, 1, __ATOMIC_RELAXED);
+                return false;
+            }
+        } while (!__atomic_compare_exchange_n(&hdr_->reserve, &pos, pos + size, true,
+                                              __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+        // 双重映射：从 pos 起 size 字节在虚拟地址上连续
+        uint8_t* p = data_ + (pos & (capacity_ - 1));
+        stt_shm_record* rec = reinterpret_cast<stt_shm_record*>(p);
+        rec->type        = type;
+        rec->reserved    = 0;
+        rec->payload_len = len;
+        rec->gen         = gen;
+        std::memcpy(rec->session_id, session_id, STT_SHM_ID_BYTES);
+        if (len > 0) std::memcpy(p + sizeof(stt_shm_record), data, len);
+
+        __atomic_store_n(&rec->size, size, __ATOMIC_RELEASE);
+
+        // 与消费者“置等待标志 → 复查 → 阻塞”配对：提交先于读取标志
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&hdr_->reader_waiting, __ATOMIC_RELAXED) &&
+            __atomic_exchange_n(&hdr_->reader_waiting, 0u, __ATOMIC_ACQ_REL)) {
+            uint64_t one = 1;
+            ssize_t r = ::write(efd_, &one, sizeof(one));
+            (void)r;
+            __atomic_fetch_add(&hdr_->wakeups, 1, __ATOMIC_RELAXED);
+        }
+        return true;
+    }
+
+    // 新消费者接入前调用：此前预留的记录都留给上一个消费者；gen 为新消费者的代号，
+    // 之后仍带旧代号写入的记录同样被新消费者跳过
+    void begin_epoch(uint32_t gen) {
+        __atomic_store_n(&hdr_->gen, gen, __ATOMIC_RELAXED);
+        __atomic_store_n(&hdr_->epoch, __atomic_load_n(&hdr_->reserve, __ATOMIC_ACQUIRE),
+                         __ATOMIC_RELEASE);
+    }
+
+    // 记录不再写入时（所属消费者已断开）计入丢弃数
+    void note_dropped() { __atomic_fetch_add(&hdr_->dropped, 1, __ATOMIC_RELAXED); }
+
+    int memfd() const { return memfd_; }
+    int eventfd_fd() const { return efd_; }
+    size_t capacity() const { return capacity_; }
+
+    // 统计：已写入字节数 / 消费者积压字节数 / 丢弃数 / 唤醒次数
+    uint64_t reserved_bytes() const { return __atomic_load_n(&hdr_->reserve, __ATOMIC_RELAXED); }
+    uint64_t backlog_bytes() const {
+        return reserved_bytes() - __atomic_load_n(&hdr_->tail, __ATOMIC_RELAXED);
+    }
+    uint64_t dropped() const { return __atomic_load_n(&hdr_->dropped, __ATOMIC_RELAXED); }
+    uint64_t wakeups() const { return __atomic_load_n(&hdr_->wakeups, __ATOMIC_RELAXED); }
+
+private:
+    SttShmRing() = default;
+
+    int      memfd_    = -1;
+    int      efd_      = -1;
+    size_t   capacity_ = 0;
+    uint8_t* base_     = nullptr;
+    uint8_t* data_     = nullptr;
+    stt_shm_header* hdr_ = nullptr;
+};
@@ -14,6 +14,7 @@
  * 1. Ort::Env / Ort::Session / Ort::MemoryInfo 只创建一次（重资源）
  * 2. 不保存任何会话状态（RNN state 由调用方维护）
  * 3. is_speech 可被多个 session 调用
+ * 4. 推理张量按线程预建，稳态推理不做堆分配
  */
 class SileroVadDetector {
 public:
@@ -66,71 +67,54 @@ public:
     bool is_speech(const std::vector<float>& pcm_float,
                    std::vector<float>& state)
     {
-        // ----------- Tensor dims -----------
-        int64_t input_dims[] = {1, static_cast<int64_t>(pcm_float.size())};
-        int64_t sr_dims[]    = {1};
-        int64_t state_dims[] = {2, 1, 128};
+        return is_speech(pcm_float.data(), pcm_float.size(), state.data());
+    }
 
-        // ----------- I/O names -----------
-        const char* input_names[]  = {"input", "sr", "state"};
-        const char* output_names[] = {"output", "stateN"};
+    /**
+     * @brief 同上，稳态不做堆分配
+     *
+     * 输入 / 输出张量按线程预先建好并绑定在线程私有缓冲区上，
+     * 每次推理只拷入音频与 state、拷出新 state（共约 3.5KB）。
+     * 首次调用或窗口长度变化时重建张量。
+     *
+     * @param state  kStateSize 个 float，原地更新
+     */
+    bool is_speech(const float* pcm, size_t n, float* state)
+    {
+        return speech_prob(pcm, n, state) >= config_.threshold;
+    }
 
-        // ----------- Build input tensors -----------
-        std::vector<Ort::Value> inputs;
-        inputs.reserve(3);
-
-        // audio input
-        inputs.emplace_back(
-            Ort::Value::CreateTensor<float>(
-                *memory_info_,
-                const_cast<float*>(pcm_float.data()),
-                pcm_float.size(),
-                input_dims,
-                2));
-
-        // sample rate
-        inputs.emplace_back(
-            Ort::Value::CreateTensor<int64_t>(
-                *memory_info_,
-                &sr_val_,
-                1,
-                sr_dims,
-                1));
-
-        // RNN state
-        inputs.emplace_back(
-            Ort::Value::CreateTensor<float>(
-                *memory_info_,
-                state.data(),
-                state.size(),
-                state_dims,
-                3));
-
-        // ----------- Run inference -----------
-        auto outputs = session_->Run(
+    /**
+     * @brief 返回语音概率，由调用方按自己的阈值判定（阈值可热更新）
+     */
+    float speech_prob(const float* pcm, size_t n, float* state)
+    {
+        Scratch& sc = scratch(n);
+
+        std::memcpy(sc.input.data(), pcm, n * sizeof(float));
+        std::memcpy(sc.state.data(), state, kStateSize * sizeof(float));
+
+        // ----------- Run inference（输出写入预绑定张量） -----------
+        static const char* input_names[]  = {"input", "sr", "state"};
+        static const char* output_names[] = {"output", "stateN"};
+
+        session_->Run(
             Ort::RunOptions{nullptr},
             input_names,
-            inputs.data(),
-            inputs.size(),
+            sc.inputs.data(),
+            sc.inputs.size(),
             output_names,
-            2);
+            sc.outputs.data(),
+            sc.outputs.size());
 
         // ----------- Update RNN state -----------
-        float* next_state =
-            outputs[1].GetTensorMutableData<float>();
-
-        std::memcpy(
-            state.data(),
-            next_state,
-            state.size() * sizeof(float));
+        std::memcpy(state, sc.state_out.data(), kStateSize * sizeof(float));
 
-        // ----------- Read score -----------
-        float score =
-            outputs[0].GetTensorMutableData<float>()[0];
-
-        return score >= config_.threshold;
+        return sc.score;
     }
 
+    static constexpr size_t kStateSize = 2 * 1 * 128;
+
 private:
     Config config_;
 
@@ -140,4 +124,54 @@ private:
     std::unique_ptr<Ort::MemoryInfo> memory_info_;
 
     int64_t sr_val_;
+
+    // 线程私有推理缓冲区与绑定在其上的张量
+    struct Scratch {
+        const SileroVadDetector* owner = nullptr;
+        size_t window = 0;
+
+        std::vector<float> input;
+        std::vector<float> state;
+        std::vector<float> state_out;
+        float              score = 0.0f;
+
+        std::vector<Ort::Value> inputs;
+        std::vector<Ort::Value> outputs;
+    };
+
+    Scratch& scratch(size_t window) {
+        thread_local Scratch sc;
+        if (sc.owner == this && sc.window == window) {
+            return sc;
+        }
+
+        sc.owner  = this;
+        sc.window = window;
+        sc.input.assign(window, 0.0f);
+        sc.state.assign(kStateSize, 0.0f);
+        sc.state_out.assign(kStateSize, 0.0f);
+
+        int64_t input_dims[] = {1, static_cast<int64_t>(window)};
+        int64_t sr_dims[]    = {1};
+        int64_t state_dims[] = {2, 1, 128};
+        int64_t score_dims[] = {1, 1};
+
+        sc.inputs.clear();
+        sc.inputs.reserve(3);
+        sc.inputs.emplace_back(Ort::Value::CreateTensor<float>(
+            *memory_info_, sc.input.data(), window, input_dims, 2));
+        sc.inputs.emplace_back(Ort::Value::CreateTensor<int64_t>(
+            *memory_info_, &sr_val_, 1, sr_dims, 1));
+        sc.inputs.emplace_back(Ort::Value::CreateTensor<float>(
+            *memory_info_, sc.state.data(), kStateSize, state_dims, 3));
+
+        sc.outputs.clear();
+        sc.outputs.reserve(2);
+        sc.outputs.emplace_back(Ort::Value::CreateTensor<float>(
+            *memory_info_, &sc.score, 1, score_dims, 2));
+        sc.outputs.emplace_back(Ort::Value::CreateTensor<float>(
+            *memory_info_, sc.state_out.data(), kStateSize, state_dims, 3));
+
+        return sc;
+    }
 };
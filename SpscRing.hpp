@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * 单生产者 / 单消费者无锁环形队列
+ *
+ * 设计原则：
+ * 1. 槽位一次性预分配，生产者 try_reserve() 拿到槽位原地填写后 commit()，
+ *    消费者 front() 原地读取后 pop()，数据不额外拷贝
+ * 2. head / tail 分处不同 cache line，各自缓存对端索引，减少跨核同步
+ * 3. 容量必须是 2 的幂
+ */
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : slots_(new T[capacity]),
+          mask_(capacity - 1)
+    {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /* ---------- 生产者 ---------- */
+
+    // 队列满时返回 nullptr
+    T* try_reserve() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    void commit() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    /* ---------- 消费者 ---------- */
+
+    // 队列空时返回 nullptr
+    T* front() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    /* ---------- 任意线程（近似值，仅用于统计） ---------- */
+
+    size_t size() const {
+        return tail_.load(std::memory_order_relaxed) -
+               head_.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::unique_ptr<T[]> slots_;
+    const size_t         mask_;
+
+    alignas(kCacheLine) std::atomic<size_t> head_{0};   // 消费者写
+    size_t tail_cache_ = 0;                             // 消费者私有
+
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};   // 生产者写
+    size_t head_cache_ = 0;                             // 生产者私有
+};
@@ -0,0 +1,105 @@
+#ifndef AEROSHELL_STT_SHM_H
+#define AEROSHELL_STT_SHM_H
+
+/*
+ * 网关 → 同机 STT 的共享内存环：内存布局（C / C++ 共用）
+ *
+ * 设计原则：
+ * 1. 整个环是一个 memfd：偏移 0 起 STT_SHM_HEADER_BYTES 字节为头，之后是 capacity 字节数据区
+ *    （capacity 为 2 的幂且页对齐）。读写双方都把数据区连续映射两次，
+ *    跨越环尾的记录在虚拟地址上仍是连续的，不需要填充记录，也不需要分段拷贝
+ * 2. 多生产者（网关各处理线程）用 CAS 推进 reserve 预留空间，写完记录体后
+ *    最后以 release 语义写 size 字段提交；单消费者从 tail 起按序读取，遇到 size == 0 即停
+ * 3. 消费者把读完的区间清零后再推进 tail，保证以后任何位置落下的记录头在提交前都读到 0
+ * 4. 所有共享字段都是普通整数，双方一律用 __atomic 内建函数访问（GCC / Clang）
+ * 5. 消费者没有数据可读时置 reader_waiting 后阻塞在 eventfd 上；
+ *    生产者提交后发现该标志才 write(eventfd)，消费者忙时生产者不做任何 syscall
+ * 6. 新消费者从 tail 起照常读取并清零（维持原则 3），但只把本代的记录交给上层：
+ *    上一个消费者没读完的积压里有没有 start 的半段语音，不能混进新消费者
+ * 7. 每条记录带写入者锁定的消费者代号（gen）。只按位置（epoch）过滤不够：生产者核对代号后、
+ *    预留空间前可能被抢占，等它写下旧段的记录时 epoch 早已推进，记录落在 epoch 之后
+ *
+ * 连接方式：网关在 -M 指定的 Unix 域 socket 上监听，消费者连上后通过 SCM_RIGHTS
+ * 收到 [memfd, eventfd] 两个 fd（附带 uint32 个数 2）。同一时刻只接受一个消费者，
+ * 连接断开即视为消费者退出，网关回退到 UDP 发送。出口方式在每段语音 start 时锁定：
+ * 消费者在一段语音中途断开或换人时，该段剩余的记录丢弃（计入 dropped），不会改走 UDP。
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STT_SHM_MAGIC        0x4d485341u   /* "ASHM" */
+#define STT_SHM_VERSION      2u
+#define STT_SHM_HEADER_BYTES 4096u
+#define STT_SHM_ID_BYTES     16u           /* 会话 ID 恒为 16 字节二进制，与 -i 无关 */
+#define STT_SHM_ALIGN        8u
+
+/* 记录类型 */
+enum {
+    STT_SHM_PCM   = 0,   /* 16 kHz / mono / int16 PCM，长度为 stt_chunk_ms 对应的样本数 */
+    STT_SHM_START = 1,   /* 语音开始，无负载 */
+    STT_SHM_END   = 2,   /* 语音结束，无负载；之前的 PCM 已全部写入 */
+    STT_SHM_OPUS  = 3    /* stt_codec = opus 时代替 PCM：负载为 10 字节帧头 + 一个 Opus 包，
+                            帧头与网关上行 v1 报文相同 [0xAE][1][seq:2][ts:4][len:2]（大端），
+                            每段语音 seq / ts 从 0 开始、编码器从头开始 */
+};
+
+typedef struct stt_shm_header {
+    /* 只读部分：网关创建时写好 */
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;          /* 数据区字节数 */
+    uint32_t sample_rate;
+    uint32_t id_bytes;
+    /* 网关在每个消费者接入前写入当时的 reserve：此前的记录属于上一个消费者，新消费者读到即丢弃 */
+    uint64_t epoch;
+    /* 与 epoch 同时写入：本消费者的代号，只有 gen 相同的记录属于它 */
+    uint32_t gen;
+    uint8_t  pad0[28];
+
+    /* 生产者：已预留到的字节位置（单调递增，取模 capacity 为数据区偏移） */
+    uint64_t reserve;
+    uint8_t  pad1[56];
+
+    /* 消费者：已读完并清零到的字节位置 */
+    uint64_t tail;
+    uint8_t  pad2[56];
+
+    /* 消费者即将阻塞在 eventfd 上 */
+    uint32_t reader_waiting;
+    uint32_t pad3;
+    uint64_t wakeups;           /* 生产者 write(eventfd) 次数 */
+    uint64_t dropped;           /* 环满时丢弃的记录数 */
+    uint8_t  pad4[40];
+} stt_shm_header;
+
+typedef struct stt_shm_record {
+    uint32_t size;              /* 整条记录字节数（含本头，STT_SHM_ALIGN 对齐）；0 = 尚未提交 */
+    uint16_t type;              /* STT_SHM_PCM / START / END / OPUS */
+    uint16_t reserved;
+    uint32_t payload_len;       /* 紧跟本头之后的负载字节数 */
+    uint32_t gen;               /* 写入者锁定的消费者代号，与头部 gen 不同即为旧段的残留 */
+    uint8_t  session_id[STT_SHM_ID_BYTES];
+} stt_shm_record;
+
+#ifdef __cplusplus
+static_assert(sizeof(stt_shm_header) == 256, "stt_shm_header layout");
+static_assert(sizeof(stt_shm_record) == 32, "stt_shm_record layout");
+#else
+_Static_assert(sizeof(stt_shm_header) == 256, "stt_shm_header layout");
+_Static_assert(sizeof(stt_shm_record) == 32, "stt_shm_record layout");
+#endif
+
+static inline uint32_t stt_shm_record_size(uint32_t payload_len) {
+    return (uint32_t)((sizeof(stt_shm_record) + payload_len + STT_SHM_ALIGN - 1) &
+                      ~(uint64_t)(STT_SHM_ALIGN - 1));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AEROSHELL_STT_SHM_H */
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * 两级分层时间轮（单线程使用，每个 worker 一个）
+ *
+ * 设计原则：
+ * 1. 第 0 级 256 槽，每槽 1 tick；第 1 级 64 槽，每槽 256 tick，
+ *    覆盖 16384 tick，更远的到期时间钳到第 1 级最远槽，到时重新判断
+ * 2. schedule / 到期都是 O(1)；第 1 级槽在第 0 级转满一圈时整体下放（cascade）
+ * 3. 不支持取消：调用方在到期回调里判断条目是否仍然有效，
+ *    回调返回新的到期 tick 即重新挂入（惰性续期），返回 0 表示丢弃
+ * 4. 槽位 vector 复用容量，稳态不分配内存
+ */
+template <class T>
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t now) : current_(now) {}
+
+    uint64_t now() const { return current_; }
+    size_t size() const { return size_; }
+
+    // 到期时间不晚于当前 tick 的条目在下一个 tick 触发
+    void schedule(T item, uint64_t expires) {
+        if (expires <= current_) {
+            expires = current_ + 1;
+        }
+        ++size_;
+        place(std::move(item), expires);
+    }
+
+    /**
+     * @brief 推进到 now，依次触发途经各 tick 的到期条目
+     * @param on_expire  uint64_t(T&)：返回 0 丢弃条目，否则按返回值重新挂入
+     */
+    template <class F>
+    void advance(uint64_t now, F&& on_expire) {
+        while (current_ < now) {
+            uint64_t t = ++current_;
+
+            if ((t & kL0Mask) == 0) {
+                cascade(t);
+            }
+
+            auto& slot = l0_[t & kL0Mask];
+            if (slot.empty()) continue;
+
+            scratch_.swap(slot);
+            for (auto& e : scratch_) {
+                uint64_t next = on_expire(e.item);
+                if (next == 0) {
+                    --size_;
+                } else {
+                    place(std::move(e.item), next > t ? next : t + 1);
+                }
+            }
+            scratch_.clear();
+        }
+    }
+
+private:
+    static constexpr int      kL0Bits  = 8;
+    static constexpr uint64_t kL0Slots = 1u << kL0Bits;
+    static constexpr uint64_t kL0Mask  = kL0Slots - 1;
+    static constexpr uint64_t kL1Slots = 64;
+    static constexpr uint64_t kL1Mask  = kL1Slots - 1;
+    static constexpr uint64_t kSpan    = kL0Slots * kL1Slots;
+
+    struct Entry {
+        T        item;
+        uint64_t expires;
+    };
+
+    void place(T&& item, uint64_t expires) {
+        uint64_t delta = expires - current_;
+        if (delta < kL0Slots) {
+            l0_[expires & kL0Mask].push_back({std::move(item), expires});
+            return;
+        }
+        if (delta >= kSpan) {
+            expires = current_ + kSpan - 1;
+        }
+        l1_[(expires >> kL0Bits) & kL1Mask].push_back({std::move(item), expires});
+    }
+
+    // t 为 256 的整数倍：把第 1 级对应槽（到期落在 [t, t+256)）下放到第 0 级
+    void cascade(uint64_t t) {
+        auto& slot = l1_[(t >> kL0Bits) & kL1Mask];
+        if (slot.empty()) return;
+
+        cascade_scratch_.swap(slot);
+        for (auto& e : cascade_scratch_) {
+            l0_[e.expires & kL0Mask].push_back(std::move(e));
+        }
+        cascade_scratch_.clear();
+    }
+
+    uint64_t current_;
+    size_t   size_ = 0;
+
+    std::vector<Entry> l0_[kL0Slots];
+    std::vector<Entry> l1_[kL1Slots];
+    std::vector<Entry> scratch_;
+    std::vector<Entry> cascade_scratch_;
+};
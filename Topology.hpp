@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * CPU / NUMA 拓扑与线程放置（不依赖 libnuma）
+ *
+ * 设计原则：
+ * 1. 拓扑从 /sys/devices/system/node 读取；没有 NUMA 信息的机器视为单节点
+ * 2. 线程绑核用 pthread_setaffinity_np；内存就近分配用 set_mempolicy(MPOL_PREFERRED)，
+ *    只影响调用线程之后的新分配（首次缺页时落在指定节点），节点内存不足时仍可回退
+ * 3. 大块缓冲区用 mmap 直接申请，可选透明大页（MADV_HUGEPAGE）或显式大页（MAP_HUGETLB），
+ *    并用 mbind 绑定到节点
+ */
+namespace topo {
+
+enum class HugePages {
+    kOff,
+    kTransparent,   // THP：madvise(MADV_HUGEPAGE)
+    kExplicit       // hugetlbfs 预留页：MAP_HUGETLB，失败回退普通页
+};
+
+// 解析 "0-3,8,10-11" 形式的 CPU / 节点列表
+inline std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    size_t i = 0;
+    while (i < s.size()) {
+        size_t end = s.find(',', i);
+        if (end == std::string::npos) end = s.size();
+        std::string tok = s.substr(i, end - i);
+        i = end + 1;
+
+        while (!tok.empty() && (tok.back() == '\n' || tok.back() == ' ')) tok.pop_back();
+        if (tok.empty()) continue;
+
+        size_t dash = tok.find('-');
+        int lo = std::stoi(tok.substr(0, dash));
+        int hi = (dash == std::string::npos) ? lo : std::stoi(tok.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) out.push_back(c);
+    }
+    return out;
+}
+
+inline std::string read_line(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+struct Topology {
+    std::vector<std::vector<int>> node_cpus;   // 下标 = 节点号
+    std::vector<int>              cpu_node;    // 下标 = CPU 号
+
+    static Topology detect() {
+        Topology t;
+        std::string online = read_line("/sys/devices/system/node/online");
+        std::vector<int> nodes = online.empty() ? std::vector<int>{} : parse_list(online);
+
+        for (int n : nodes) {
+            std::string cpus = read_line(
+                "/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+            if (int(t.node_cpus.size()) <= n) t.node_cpus.resize(n + 1);
+            t.node_cpus[n] = parse_list(cpus);
+        }
+
+        if (t.node_cpus.empty()) {
+            // 无 NUMA 信息：全部在线 CPU 视为节点 0
+            std::string cpus = read_line("/sys/devices/system/cpu/online");
+            t.node_cpus.push_back(cpus.empty() ? std::vector<int>{0} : parse_list(cpus));
+        }
+
+        for (size_t n = 0; n < t.node_cpus.size(); ++n) {
+            for (int c : t.node_cpus[n]) {
+                if (int(t.cpu_node.size()) <= c) t.cpu_node.resize(c + 1, 0);
+                t.cpu_node[c] = int(n);
+            }
+        }
+        return t;
+    }
+
+    int nodes() const { return int(node_cpus.size()); }
+
+    int node_of(int cpu) const {
+        return (cpu >= 0 && cpu < int(cpu_node.size())) ? cpu_node[cpu] : 0;
+    }
+
+    // "auto"：各节点轮流取核，worker 均匀分布到所有节点
+    std::vector<int> spread() const {
+        std::vector<int> out;
+        for (size_t k = 0;; ++k) {
+            bool any = false;
+            for (auto& cpus : node_cpus) {
+                if (k < cpus.size()) {
+                    out.push_back(cpus[k]);
+                    any = true;
+                }
+            }
+            if (!any) break;
+        }
+        return out;
+    }
+};
+
+/* ---------- 线程放置（作用于调用线程） ---------- */
+
+inline bool pin_to_cpus(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+inline bool prefer_node(int node) {
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) == 0;
+}
+
+// 返回调用线程当前所在 CPU（日志用）
+inline int current_cpu() {
+    return sched_getcpu();
+}
+
+/* ---------- 节点本地大块缓冲区 ---------- */
+
+inline void* alloc_buffer(size_t bytes, int node, HugePages hp) {
+    static constexpr size_t kHugePage = 2 * 1024 * 1024;
+    void* p = MAP_FAILED;
+
+    if (hp == HugePages::kExplicit) {
+        size_t sz = (bytes + kHugePage - 1) / kHugePage * kHugePage;
+        p = mmap(nullptr, sz, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        if (hp != HugePages::kOff) {
+            madvise(p, bytes, MADV_HUGEPAGE);
+        }
+    }
+
+    if (node >= 0) {
+        unsigned long mask = 1UL << node;
+        syscall(SYS_mbind, p, bytes, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+    }
+    return p;
+}
+
+/* ---------- 启动报告用的系统状态 ---------- */
+
+inline std::string thp_mode() {
+    std::string s = read_line("/sys/kernel/mm/transparent_hugepage/enabled");
+    size_t l = s.find('['), r = s.find(']');
+    return (l != std::string::npos && r != std::string::npos) ? s.substr(l + 1, r - l - 1)
+                                                              : "unavailable";
+}
+
+inline std::string hugepages_reserved() {
+    std::string s = read_line("/proc/sys/vm/nr_hugepages");
+    return s.empty() ? "0" : s;
+}
+
+}  // namespace topo
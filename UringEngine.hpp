@@ -0,0 +1,334 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <liburing.h>
+
+/**
+ * io_uring 网络引擎（每个 worker 一个实例，单线程使用）
+ *
+ * 设计原则：
+ * 1. 收包：provided-buffer ring + multishot recvmsg，一次提交持续收包，
+ *    接收缓冲区由内核从 buf ring 中挑选，处理完后归还，无逐包 syscall
+ * 2. 发包：发送槽位预分配，send() 只填 SQE 不进内核，
+ *    一轮 CQE 处理完后统一 io_uring_submit，多个 sendmsg 合并为一次 syscall
+ * 3. 槽位耗尽时返回 false，由调用方回退到同步 sendto
+ */
+class UringEngine {
+public:
+    struct Config {
+        unsigned entries        = 1024;   // SQ 深度
+        unsigned recv_buffers   = 1024;   // buf ring 条目数，必须是 2 的幂
+        unsigned recv_buf_size  = 8192;   // 单个接收 payload 上限
+        unsigned send_slots     = 1024;
+        unsigned send_slot_size = 0;      // 单条出站报文上限，0 = 与 recv_buf_size 相同
+    };
+
+    // 单线程写、统计线程读：relaxed 原子即可，写端不需要 lock 前缀
+    struct Stats {
+        std::atomic<uint64_t> recv_packets{0};
+        std::atomic<uint64_t> send_packets{0};
+        std::atomic<uint64_t> submit_calls{0};   // 实际进入内核的次数
+        std::atomic<uint64_t> recv_rearms{0};    // multishot 被内核终止后的重新提交
+        std::atomic<uint64_t> send_errors{0};
+    };
+
+    explicit UringEngine(const Config& config)
+        : config_(config)
+    {
+        if (config_.send_slot_size == 0) {
+            config_.send_slot_size = config_.recv_buf_size;
+        }
+
+        io_uring_params params{};
+        params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+
+        int ret = io_uring_queue_init_params(config_.entries, &ring_, &params);
+        if (ret < 0) {
+            throw std::runtime_error(
+                "io_uring_queue_init failed: " + std::string(strerror(-ret)));
+        }
+
+        // ---------- provided-buffer ring（注册到内核的接收缓冲区） ----------
+        recv_stride_ = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in)
+                     + config_.recv_buf_size;
+        recv_mem_.resize(size_t(config_.recv_buffers) * recv_stride_);
+
+        int err = 0;
+        buf_ring_ = io_uring_setup_buf_ring(
+            &ring_, config_.recv_buffers, kRecvBufGroup, 0, &err);
+        if (!buf_ring_) {
+            io_uring_queue_exit(&ring_);
+            throw std::runtime_error(
+                "io_uring_setup_buf_ring failed: " + std::string(strerror(-err)));
+        }
+
+        buf_mask_ = io_uring_buf_ring_mask(config_.recv_buffers);
+        for (unsigned i = 0; i < config_.recv_buffers; ++i) {
+            io_uring_buf_ring_add(
+                buf_ring_, recv_buf(i), recv_stride_, i, buf_mask_, i);
+        }
+        io_uring_buf_ring_advance(buf_ring_, config_.recv_buffers);
+
+        // recvmsg 模板：只要源地址，不要控制消息
+        recv_msg_ = {};
+        recv_msg_.msg_namelen = sizeof(sockaddr_in);
+
+        // ---------- 发送槽位 ----------
+        slots_.resize(config_.send_slots);
+        send_mem_.resize(size_t(config_.send_slots) * config_.send_slot_size);
+        free_slots_.reserve(config_.send_slots);
+        for (unsigned i = 0; i < config_.send_slots; ++i) {
+            SendSlot& sl = slots_[i];
+            sl.iov.iov_base      = send_mem_.data() + size_t(i) * config_.send_slot_size;
+            sl.msg.msg_name      = &sl.to;
+            sl.msg.msg_namelen   = sizeof(sl.to);
+            sl.msg.msg_iov       = &sl.iov;
+            sl.msg.msg_iovlen    = 1;
+            free_slots_.push_back(config_.send_slots - 1 - i);
+        }
+    }
+
+    ~UringEngine() {
+        io_uring_free_buf_ring(&ring_, buf_ring_, config_.recv_buffers, kRecvBufGroup);
+        io_uring_queue_exit(&ring_);
+    }
+
+    UringEngine(const UringEngine&) = delete;
+    UringEngine& operator=(const UringEngine&) = delete;
+
+    /**
+     * @brief 在 fd 上挂一个 multishot recvmsg（每个引擎只支持一个接收 fd；stop_recv 之后可再次调用恢复）
+     */
+    bool add_recv(int fd) {
+        recv_fd_ = fd;
+        stopping_ = recv_stopped_ = false;
+        return arm_recv();
+    }
+
+    /**
+     * @brief 取消接收（进程热交接前调用）
+     *
+     * 之后继续 poll() 直到 recv_active() 为 false：取消生效前内核已收进缓冲区的包
+     * 仍交给回调处理，不会丢在本进程里。
+     */
+    void stop_recv() {
+        if (recv_fd_ < 0 || stopping_) return;
+
+        io_uring_sqe* sqe = get_sqe();
+        if (!sqe) return;
+        io_uring_prep_cancel64(sqe, kRecvTag, 0);
+        io_uring_sqe_set_data64(sqe, kCancelTag);
+
+        ++pending_;
+        stopping_ = true;
+    }
+
+    bool recv_active() const { return recv_fd_ >= 0 && !recv_stopped_; }
+
+    /**
+     * @brief 排队一个 UDP 发送（hdr + data 拼接后拷入发送槽位）
+     *
+     * 只填 SQE，真正提交发生在 poll() 末尾或 flush()。
+     * @return false : 槽位耗尽 / 报文过大，调用方应回退到同步发送
+     */
+    bool send(int fd, const sockaddr_in& to,
+              const void* hdr, size_t hlen,
+              const void* data, size_t len)
+    {
+        if (free_slots_.empty() || hlen + len > config_.send_slot_size) {
+            return false;
+        }
+
+        io_uring_sqe* sqe = get_sqe();
+        if (!sqe) {
+            return false;
+        }
+
+        uint32_t idx = free_slots_.back();
+        free_slots_.pop_back();
+
+        SendSlot& sl = slots_[idx];
+        uint8_t* p = static_cast<uint8_t*>(sl.iov.iov_base);
+        if (hlen) std::memcpy(p, hdr, hlen);
+        if (len)  std::memcpy(p + hlen, data, len);
+        sl.iov.iov_len = hlen + len;
+        sl.to = to;
+
+        io_uring_prep_sendmsg(sqe, fd, &sl.msg, 0);
+        io_uring_sqe_set_data64(sqe, kSendTag | idx);
+
+        ++pending_;
+        return true;
+    }
+
+    /**
+     * @brief 提交已排队的 SQE
+     */
+    void flush() {
+        if (pending_ == 0) return;
+        io_uring_submit(&ring_);
+        bump(stats_.submit_calls);
+        pending_ = 0;
+    }
+
+    /**
+     * @brief 提交挂起的 SQE 并等待至少一个 CQE（或超时），随后处理本轮所有 CQE
+     *
+     * @param on_packet  void(const uint8_t* data, size_t len, const sockaddr_in& from)
+     * @param timeout_ms 等待上限，用于让调用方周期性做会话过期等工作
+     *
+     * @return 本轮处理的 CQE 数
+     */
+    template <class OnPacket>
+    int poll(OnPacket&& on_packet, int timeout_ms) {
+        __kernel_timespec ts{};
+        ts.tv_sec  = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+
+        io_uring_cqe* cqe = nullptr;
+        io_uring_submit_and_wait_timeout(&ring_, &cqe, 1, &ts, nullptr);
+        bump(stats_.submit_calls);
+        pending_ = 0;
+
+        unsigned head;
+        unsigned seen = 0;
+        int recycled = 0;
+        bool rearm = false;
+
+        io_uring_for_each_cqe(&ring_, head, cqe) {
+            ++seen;
+            uint64_t tag = io_uring_cqe_get_data64(cqe);
+
+            if (tag == kCancelTag) {
+                continue;
+            }
+            if (tag & kSendTag) {
+                free_slots_.push_back(uint32_t(tag & ~kSendTag));
+                if (cqe->res < 0) bump(stats_.send_errors);
+                else              bump(stats_.send_packets);
+                continue;
+            }
+
+            // ---------- 收包 ----------
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                // multishot 已终止：主动取消时到此为止，否则（例如 buf ring 用尽）重新提交
+                if (stopping_) recv_stopped_ = true;
+                else           rearm = true;
+            }
+            if (cqe->res < 0 || !(cqe->flags & IORING_CQE_F_BUFFER)) {
+                continue;
+            }
+
+            unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            uint8_t* buf = recv_buf(bid);
+
+            io_uring_recvmsg_out* o =
+                io_uring_recvmsg_validate(buf, cqe->res, &recv_msg_);
+            if (o && !(o->flags & MSG_TRUNC)) {
+                sockaddr_in from{};
+                std::memcpy(&from, io_uring_recvmsg_name(o),
+                            std::min<size_t>(o->namelen, sizeof(from)));
+
+                on_packet(
+                    static_cast<const uint8_t*>(
+                        io_uring_recvmsg_payload(o, &recv_msg_)),
+                    io_uring_recvmsg_payload_length(o, cqe->res, &recv_msg_),
+                    from);
+                bump(stats_.recv_packets);
+            }
+
+            // 处理完立即归还缓冲区
+            io_uring_buf_ring_add(
+                buf_ring_, buf, recv_stride_, bid, buf_mask_, recycled++);
+        }
+
+        io_uring_cq_advance(&ring_, seen);
+        if (recycled) {
+            io_uring_buf_ring_advance(buf_ring_, recycled);
+        }
+        if (rearm) {
+            arm_recv();
+            bump(stats_.recv_rearms);
+        }
+
+        // 本轮回调里排队的发送一次性提交
+        flush();
+        return int(seen);
+    }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    static constexpr int      kRecvBufGroup = 0;
+    static constexpr uint64_t kRecvTag      = 0;
+    static constexpr uint64_t kSendTag      = 1ULL << 63;
+    static constexpr uint64_t kCancelTag    = 1ULL << 62;
+
+    struct SendSlot {
+        msghdr      msg{};
+        iovec       iov{};
+        sockaddr_in to{};
+    };
+
+    static void bump(std::atomic<uint64_t>& c) {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    uint8_t* recv_buf(unsigned bid) {
+        return recv_mem_.data() + size_t(bid) * recv_stride_;
+    }
+
+    // SQ 满时先把已排队的提交掉再取
+    io_uring_sqe* get_sqe() {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        if (!sqe) {
+            flush();
+            sqe = io_uring_get_sqe(&ring_);
+        }
+        return sqe;
+    }
+
+    bool arm_recv() {
+        io_uring_sqe* sqe = get_sqe();
+        if (!sqe) return false;
+
+        io_uring_prep_recvmsg_multishot(sqe, recv_fd_, &recv_msg_, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kRecvBufGroup;
+        io_uring_sqe_set_data64(sqe, kRecvTag);
+
+        ++pending_;
+        return true;
+    }
+
+    Config config_;
+
+    io_uring ring_{};
+
+    io_uring_buf_ring*   buf_ring_ = nullptr;
+    int                  buf_mask_ = 0;
+    size_t               recv_stride_ = 0;
+    std::vector<uint8_t> recv_mem_;
+    msghdr               recv_msg_{};
+    int                  recv_fd_ = -1;
+    bool                 stopping_ = false;
+    bool                 recv_stopped_ = false;
+
+    std::vector<SendSlot> slots_;
+    std::vector<uint8_t>  send_mem_;
+    std::vector<uint32_t> free_slots_;
+
+    unsigned pending_ = 0;
+    Stats    stats_;
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 工作窃取调度器（固定线程池）
+ *
+ * 设计原则：
+ * 1. 每个线程一个任务双端队列：本线程从队头取（FIFO，先到先处理，控制尾延迟），
+ *    空闲线程从其它队列的队尾窃取
+ * 2. submit(hint) 把任务投到 hint 对应的队列，同一会话倾向落在同一线程，cache 局部性好；
+ *    负载不均时由窃取自动摊平
+ * 3. 全部空闲时在条件变量上短暂休眠，有新任务时唤醒一个
+ * 4. 任务互斥（同一会话不会在两个线程上同时运行）由调用方保证：任务只在未入队时才提交
+ * 5. 队列是按 2 的幂扩容的环形缓冲区，容量只增不减，稳态入队 / 出队不分配内存
+ */
+template <class Task>
+class WorkStealingScheduler {
+public:
+    using RunFn = std::function<void(Task& task, int thread_index)>;
+
+    struct ThreadStats {
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> busy_ns{0};
+    };
+
+    WorkStealingScheduler(int threads, RunFn run)
+        : run_(std::move(run))
+    {
+        for (int i = 0; i < threads; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // 启动工作线程（与其它后台线程一样 detach，进程生命周期内常驻）
+    // on_thread_start(i) 在线程 i 进入调度循环前调用，可用于绑核；
+    // on_idle(i) 在线程 i 找不到任务、即将休眠前调用，可用于发出攒批的输出
+    void start(std::function<void(int)> on_thread_start = {},
+               std::function<void(int)> on_idle = {}) {
+        for (int i = 0; i < int(queues_.size()); ++i) {
+            std::thread([this, i, on_thread_start, on_idle] {
+                if (on_thread_start) on_thread_start(i);
+                thread_main(i, on_idle);
+            }).detach();
+        }
+    }
+
+    void submit(Task task, size_t hint) {
+        Queue& q = *queues_[hint % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lk(q.mu);
+            q.tasks.push_back(std::move(task));
+        }
+
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lk(idle_mu_);
+            idle_cv_.notify_one();
+        }
+    }
+
+    int threads() const { return int(queues_.size()); }
+
+    size_t queued(int i) const {
+        std::lock_guard<std::mutex> lk(queues_[i]->mu);
+        return queues_[i]->tasks.size();
+    }
+
+    const ThreadStats& stats(int i) const { return queues_[i]->stats; }
+
+private:
+    // 双端环形缓冲区（调用方持 Queue::mu）
+    class TaskRing {
+    public:
+        bool   empty() const { return count_ == 0; }
+        size_t size() const { return count_; }
+
+        void push_back(Task t) {
+            if (count_ == buf_.size()) grow();
+            buf_[(head_ + count_) & (buf_.size() - 1)] = std::move(t);
+            ++count_;
+        }
+
+        Task pop_front() {
+            Task t = std::move(buf_[head_]);
+            buf_[head_] = Task{};
+            head_ = (head_ + 1) & (buf_.size() - 1);
+            --count_;
+            return t;
+        }
+
+        Task pop_back() {
+            size_t i = (head_ + count_ - 1) & (buf_.size() - 1);
+            Task t = std::move(buf_[i]);
+            buf_[i] = Task{};
+            --count_;
+            return t;
+        }
+
+    private:
+        void grow() {
+            std::vector<Task> next(buf_.empty() ? 64 : buf_.size() * 2);
+            for (size_t i = 0; i < count_; ++i) {
+                next[i] = std::move(buf_[(head_ + i) & (buf_.size() - 1)]);
+            }
+            buf_.swap(next);
+            head_ = 0;
+        }
+
+        std::vector<Task> buf_;
+        size_t head_  = 0;
+        size_t count_ = 0;
+    };
+
+    struct Queue {
+        mutable std::mutex mu;
+        TaskRing           tasks;
+        ThreadStats        stats;
+    };
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t d = 1) {
+        c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+
+    bool pop_own(int i, Task& out) {
+        Queue& q = *queues_[i];
+        std::lock_guard<std::mutex> lk(q.mu);
+        if (q.tasks.empty()) return false;
+        out = q.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(int i, Task& out) {
+        int n = int(queues_.size());
+        for (int k = 1; k < n; ++k) {
+            Queue& victim = *queues_[(i + k) % n];
+            std::lock_guard<std::mutex> lk(victim.mu);
+            if (victim.tasks.empty()) continue;
+            out = victim.tasks.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void thread_main(int i, const std::function<void(int)>& on_idle) {
+        ThreadStats& st = queues_[i]->stats;
+        Task task;
+
+        while (true) {
+            if (pop_own(i, task)) {
+                // 本线程队列
+            } else if (steal(i, task)) {
+                bump(st.steals);
+            } else {
+                if (on_idle) on_idle(i);
+                // 全部为空：短暂休眠；超时兜底避免唤醒丢失
+                sleepers_.fetch_add(1, std::memory_order_seq_cst);
+                {
+                    std::unique_lock<std::mutex> lk(idle_mu_);
+                    idle_cv_.wait_for(lk, std::chrono::milliseconds(1));
+                }
+                sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+                continue;
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+            run_(task, i);
+            task = Task{};
+            bump(st.runs);
+            bump(st.busy_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count());
+        }
+    }
+
+    RunFn run_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    std::mutex              idle_mu_;
+    std::condition_variable idle_cv_;
+    std::atomic<int>        sleepers_{0};
+};
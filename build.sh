@@ -71,6 +71,20 @@ cd "$ROOT_DIR"
 
 echo ">>> [4/6] 编译主程序 aec_process <<<"
 
+# 可选：liburing 存在时启用 io_uring 网络引擎（运行时 -e uring 选择）
+URING_FLAGS=""
+if pkg-config --exists liburing 2>/dev/null; then
+    URING_FLAGS="-DAEROSHELL_WITH_IO_URING $(pkg-config --cflags --libs liburing)"
+    echo "  - liburing found, io_uring engine enabled"
+fi
+
+# 可选：COUNT_ALLOCS=1 ./build.sh 编入堆分配计数（替换 operator new，诊断用）
+DIAG_FLAGS=""
+if [ "${COUNT_ALLOCS:-0}" = "1" ]; then
+    DIAG_FLAGS="-DAEROSHELL_COUNT_ALLOCS"
+    echo "  - heap allocation counter enabled"
+fi
+
 g++ main.cpp -std=c++17 -O2 \
     -I"$ROOT_DIR" \
     -I"$WEBRTC_APM_INSTALL/include" \
@@ -90,6 +104,8 @@ g++ main.cpp -std=c++17 -O2 \
     -lwebrtc_vad \
     -lonnxruntime \
     -lopus \
+    $URING_FLAGS \
+    $DIAG_FLAGS \
     -lpthread -lm \
     -Wl,-rpath,'$ORIGIN' \
     -o aec_process
@@ -2,12 +2,17 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <future>
 #include <unordered_map>
 #include <memory>
 #include <cstring>
-#include <random>
 #include <thread>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -23,9 +28,27 @@
 #include "audio_processing.h"
 
 #include "webrtc_vad.h"
+#define AEROSHELL_ALLOC_COUNTER_MAIN
+#include "AllocCounter.hpp"
 #include "SileroVadDetector.hpp"
+#include "SessionTable.hpp"
+#include "SessionId.hpp"
+#include "TimerWheel.hpp"
+#include "JitterBuffer.hpp"
+#include "SpscRing.hpp"
+#include "WorkStealingScheduler.hpp"
+#include "Topology.hpp"
+#include "Handoff.hpp"
+#include "Rcu.hpp"
+#include "RuntimeConfig.hpp"
+#include "SendBatch.hpp"
+#include "ShmRing.hpp"
 #include "ten_vad.h"
 
+#ifdef AEROSHELL_WITH_IO_URING
+#include "UringEngine.hpp"
+#endif
+
 using namespace webrtc;
 
 /* ================= 日志宏 ================= */
@@ -38,10 +61,11 @@ using namespace webrtc;
 
 static constexpr int kSampleRate = 16000;
 static constexpr int kFrameSize  = 160;
+static constexpr int kMaxPacketSamples = kSampleRate * 120 / 1000;   // Opus 单包最长 120ms
 
-static constexpr int SESSION_UDP_TIMEOUT_SEC    = 30;
-static constexpr int SESSION_SPEECH_TIMEOUT_SEC = 120;
-static constexpr int STT_PORT = 9000;
+// 静音判停、VAD 阈值、会话超时、APM 开关、STT 地址可热加载，见 RuntimeConfig.hpp
+std::string g_config_path;   // -C，空 = 全部取默认值
+rcu::Cell<RuntimeConfig> g_config{std::make_unique<RuntimeConfig>(RuntimeConfig::defaults())};
 
 std::unique_ptr<SileroVadDetector> g_silero_vad;
 
@@ -52,34 +76,148 @@ enum class VadMode {
 };
 
 
-VadMode g_vad_mode = VadMode::kSilero;
+VadMode g_vad_mode = VadMode::kSilero;   // 默认引擎：legacy / v1 报文与 profile 未指定时使用
+
+static constexpr int kVadModes = 3;
+
+const char* vad_name(VadMode m) {
+    return m == VadMode::kSilero ? "Silero" : m == VadMode::kTenVad ? "TenVAD" : "WebRTC";
+}
+
+enum class IoEngine {
+    kSocket = 0,   // recvfrom / recvmmsg + 同步 sendto
+    kUring  = 1    // io_uring multishot recvmsg + 批量 sendmsg SQE
+};
+
+IoEngine g_io_engine = IoEngine::kSocket;
 std::string g_model_path = "./silero_vad.onnx";
-int g_sockfd;
 
 /* ================= 工具 ================= */
 
-std::string generate_uuid() {
-    static const char* chars = "0123456789abcdef";
-    std::string uuid;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 15);
-    for (int i = 0; i < 32; ++i) uuid += chars[dis(gen)];
-    return uuid;
+/* ================= 会话 ID 报文格式 =================
+ *
+ * STT 上行与 AI 回包都以会话 ID 开头：
+ * bin（默认）: 16 字节二进制
+ * hex        : 32 个 hex 字符（旧版格式，兼容尚未升级的 STT / AI 服务）
+ */
+enum class IdWire {
+    kBinary,
+    kHex
+};
+
+IdWire g_id_wire = IdWire::kBinary;
+
+inline size_t id_wire_size() {
+    return g_id_wire == IdWire::kHex ? SessionId::kHexSize : SessionId::kSize;
+}
+
+/* ================= 负载降级阶梯 =================
+ *
+ * 过载时按会话逐级降低处理开销，而不是让所有会话一起排队丢包：
+ *   L0 配置的 VAD + NS + AEC
+ *   L1 Silero → TenVAD
+ *   L2 VAD → WebRTC VAD
+ *   L3 关闭 NS
+ *   L4 关闭 AEC
+ * 对某个会话没有实际变化的级别（例如本来就是 WebRTC VAD 的 L1 / L2）直接跨过。
+ *
+ * 全局压力 g_pressure ∈ [0, 2 × kMaxDegradeLevel]：前半段只降级静默会话，
+ * 压力继续升高后才开始降级正在说话的会话。
+ */
+
+static constexpr int kMaxDegradeLevel   = 4;
+static constexpr int kDegradeStepFrames = 100;   // 单会话每 1s 最多变化一级
+
+struct DegradeEffect {
+    VadMode vad;
+    bool    ns;
+    bool    aec;
+
+    bool operator==(const DegradeEffect& o) const {
+        return vad == o.vad && ns == o.ns && aec == o.aec;
+    }
+};
+
+DegradeEffect degrade_effect(VadMode base, int level) {
+    VadMode vad = base;
+    if (level >= 1 && base == VadMode::kSilero) vad = VadMode::kTenVad;
+    if (level >= 2) vad = VadMode::kWebRTC;
+    return {vad, level < 3, level < 4};
+}
+
+std::atomic<int> g_pressure{0};
+int g_degrade_high_pct = 85;   // 0 = 关闭降级控制器
+
+std::atomic<uint64_t> g_degrade_down{0};
+std::atomic<uint64_t> g_degrade_up{0};
+std::atomic<int64_t>  g_level_sessions[kMaxDegradeLevel + 1] = {};
+
+inline int degrade_target(bool speaking) {
+    int p = g_pressure.load(std::memory_order_relaxed);
+    return speaking ? std::max(0, p - kMaxDegradeLevel) : std::min(p, kMaxDegradeLevel);
 }
 
 /* ================= Session ================= */
 
-class AudioSession {
+// STT 聚合块上限：RuntimeConfig::stt_chunk_ms 最大 200ms
+static constexpr int kMaxSttChunk = kSampleRate / 1000 * RuntimeConfig::kMaxSttChunkMs;
+static constexpr int kMaxPreroll  = kSampleRate / 1000 * RuntimeConfig::kMaxPrerollMs;
+
+static constexpr int kSileroMinWindow = 512;
+static constexpr int kSileroWindow =
+    (kSileroMinWindow + kFrameSize - 1) / kFrameSize * kFrameSize;
+
+struct PipelineLane;
+
+// 调度器模式下的会话邮箱槽位：原始报文 + 到达时刻
+static constexpr int    kMailboxPacketSize = 1300;   // v1 头 + Opus 最大 1275 字节
+static constexpr size_t kMailboxSlots      = 16;
+
+struct PacketSlot {
+    int64_t  arrival_us = 0;
+    uint16_t len = 0;
+    uint8_t  data[kMailboxPacketSize];
+};
+
+// 配置与降级级别共同决定 APM 开关：降级只会关掉功能，不会打开配置里关掉的功能
+AudioProcessing::Config make_apm_config(const RuntimeConfig& rc, const DegradeEffect& e) {
+    AudioProcessing::Config cfg;
+    cfg.echo_canceller.enabled    = rc.apm_aec && e.aec;
+    cfg.noise_suppression.enabled = rc.apm_ns && e.ns;
+    cfg.noise_suppression.level   =
+        AudioProcessing::Config::NoiseSuppression::Level(rc.apm_ns_level);
+    return cfg;
+}
+
+class AudioSession : public std::enable_shared_from_this<AudioSession> {
 public:
-    std::string session_id;
+    SessionId session_id;
+    char      id_hex[SessionId::kHexSize + 1];   // 只用于日志与 hex 报文格式
     sockaddr_in addr{};
+    int sockfd = -1;   // 所属 worker 的 socket，回包 / STT 均从此发出
 
+    // 解码器状态放在会话自有的预分配内存里（opus_decoder_init），回收时原地重置
+    std::unique_ptr<uint8_t[]> decoder_mem;
     OpusDecoder* decoder = nullptr;
     rtc::scoped_refptr<AudioProcessing> apm;
 
   
-    VadMode mode;
+    VadMode mode;             // 当前生效的 VAD（可能被降级）
+    const VadMode base_mode;  // 配置的 VAD
+
+    int degrade_level = 0;
+    int frames_since_step = 0;
+
+    uint64_t config_version = 0;   // 已套用的 RuntimeConfig 版本，0 = 尚未套用
+
+    // 客户端 profile 允许的 APM 功能（v2 报文），降级 / 配置只能在此基础上再关闭
+    bool profile_aec = true;
+    bool profile_ns  = true;
+
+    // 过期原因：worker 摘除时记下，由回收线程连同会话统计一起写日志
+    bool expired_udp    = false;
+    bool expired_speech = false;
+
     //webrtc vad
     VadInst* webrtc_vad_inst = nullptr;
 
@@ -89,20 +227,95 @@ public:
     //ten vad
    ten_vad_handle_t ten_vad = nullptr;
     
-    std::vector<float> pcm_buffer;
+    // Silero 输入窗口：按 10ms 帧累计到 ≥512 samples（即 4 帧 640 samples）再推理
+    float silero_window[kSileroWindow];
+    int   silero_fill = 0;
+
+    // 带序号的 v1 报文先进抖动缓冲，按序解码
+    JitterBuffer jitter;
+    int64_t last_packet_us = 0;             // worker 写：最近一次收包（单调时钟）
+    std::atomic<bool> jitter_held{false};   // 媒体处理线程写：缓冲里还有未出队的包
+
+    // 解码输出按 10ms 切块，不足一块的尾巴留到下一包补齐（2.5/5ms 帧）
+    int16_t pcm_carry[kFrameSize] = {};
+    int     carry_len = 0;
+    int     last_packet_samples = kFrameSize;   // 丢包补帧按上一包时长合成
 
     bool is_speaking   = false;
     bool stt_started   = false;
     int  silence_frames = 0;
+    uint32_t stt_shm_gen = 0;   // 本段语音锁定的共享内存消费者代号，0 = 本段走 UDP
+
+    // 发往 STT 的 PCM 按 stt_chunk_ms 聚合成一块再发，end 前强制发出
+    int16_t stt_chunk[kMaxSttChunk];
+    int     stt_chunk_fill = 0;
+
+    // 未在说话时最近处理过的 PCM（环形，按 10ms 帧写入），start 之后补发给 STT
+    int16_t preroll[kMaxPreroll];
+    int     preroll_head = 0;   // 下一帧写入位置（样本）
+    int     preroll_fill = 0;   // 有效样本数
+
+    void preroll_push(const int16_t* pcm) {
+        memcpy(preroll + preroll_head, pcm, kFrameSize * sizeof(int16_t));
+        preroll_head = (preroll_head + kFrameSize) % kMaxPreroll;
+        preroll_fill = std::min(preroll_fill + kFrameSize, kMaxPreroll);
+    }
+
+    // STT 出口 Opus 编码器（stt_codec = opus）：与解码器一样放在会话自有内存里，
+    // 首次用到时分配，之后随会话留在池里复用。编码器的输入帧复用 stt_chunk 攒
+    std::unique_ptr<uint8_t[]> encoder_mem;
+    OpusEncoder* encoder = nullptr;
+    int      stt_opus_frame = 0;   // 本段语音的 Opus 帧长（样本），0 = 本段发 PCM
+    uint16_t stt_opus_seq   = 0;
+    uint32_t stt_opus_ts    = 0;
+
+    bool ensure_encoder() {
+        if (encoder) return true;
+        encoder_mem.reset(new uint8_t[opus_encoder_get_size(1)]);
+        encoder = reinterpret_cast<OpusEncoder*>(encoder_mem.get());
+        if (opus_encoder_init(encoder, kSampleRate, 1, OPUS_APPLICATION_VOIP) != OPUS_OK) {
+            LOGE("[Opus] encoder init failed");
+            encoder = nullptr;
+            encoder_mem.reset();
+            return false;
+        }
+        return true;
+    }
+
+    // 新一段语音：编码器从头开始，码率 / 复杂度取当前配置
+    void reset_encoder(const RuntimeConfig& rc) {
+        opus_encoder_ctl(encoder, OPUS_RESET_STATE);
+        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(rc.stt_opus_bitrate));
+        opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(rc.stt_opus_complexity));
+        opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    }
+
+    // 实时性核算：当前正在解码的报文的到达时刻，以及本会话的帧 / 超时计数
+    int64_t  frame_arrival_us = 0;
+    uint64_t deadline_frames  = 0;
+    uint64_t deadline_misses  = 0;
+
+    PipelineLane* lane = nullptr;   // 流水线模式下固定所属 lane，保证单会话帧序
+
+    // 调度器模式：worker 投递报文（单生产者），持有 scheduled 的调度线程消费（单消费者）
+    std::unique_ptr<SpscRing<PacketSlot>> mailbox;
+    std::atomic<bool> scheduled{false};
 
     time_t last_active_time = 0;
-    time_t last_speech_time = 0;
+    std::atomic<time_t> last_speech_time{0};   // 流水线模式下由 VAD 线程写、worker 读
 
-    explicit AudioSession(VadMode m) : mode(m) {
-        session_id = generate_uuid();
+    explicit AudioSession(VadMode m) : mode(m), base_mode(m) {
+        new_id();
 
-        int err = 0;
-        decoder = opus_decoder_create(kSampleRate, 1, &err);
+        decoder_mem.reset(new uint8_t[opus_decoder_get_size(1)]);
+        decoder = reinterpret_cast<OpusDecoder*>(decoder_mem.get());
+        if (opus_decoder_init(decoder, kSampleRate, 1) != OPUS_OK) {
+            LOGE("[Opus] decoder init failed");
+        }
+        // 出口配置为 opus 时编码器随会话一起预热，start 时不再分配
+        if (g_config.read()->stt_opus) {
+            ensure_encoder();
+        }
 
         apm = AudioProcessingBuilder().Create();
         AudioProcessing::Config cfg;
@@ -113,10 +326,9 @@ public:
         if (mode == VadMode::kWebRTC) {
             webrtc_vad_inst = WebRtcVad_Create();
             WebRtcVad_Init(webrtc_vad_inst);
-            WebRtcVad_set_mode(webrtc_vad_inst, 3);
+            WebRtcVad_set_mode(webrtc_vad_inst, g_config.read()->webrtc_vad_mode);
         }else if (mode == VadMode::kSilero) {
-    silero_state.assign(2 * 1 * 128, 0.0f); // 必须
-    pcm_buffer.reserve(512);
+    silero_state.assign(SileroVadDetector::kStateSize, 0.0f); // 必须
 }
         else if (mode == VadMode::kTenVad) {
 
@@ -133,387 +345,3102 @@ if (ten_vad_create(&ten_vad, hop_size, threshold) != 0) {
 }
 
         last_active_time = time(nullptr);
-        last_speech_time = last_active_time;
+        last_speech_time.store(last_active_time, std::memory_order_relaxed);
     }
 
     ~AudioSession() {
-        if (decoder) opus_decoder_destroy(decoder);
         if (webrtc_vad_inst) WebRtcVad_Free(webrtc_vad_inst);
    if (ten_vad) {
     ten_vad_destroy(&ten_vad);
     ten_vad = nullptr;
 }
-        LOGI("[Session] destroyed {}", session_id);
-        
     }
-};
-
-/* ================= 全局会话表 ================= */
 
-std::mutex g_session_mu;
-std::unordered_map<std::string, std::shared_ptr<AudioSession>> g_sessions;
-std::unordered_map<std::string, std::shared_ptr<AudioSession>> g_id_map;
+    void log_summary() const {
+        if (expired_udp || expired_speech) {
+            LOGW("Session {} timeout udp={} speech={}", id_hex, expired_udp, expired_speech);
+        }
+        const auto& jc = jitter.counters();
+        LOGI("[Session] destroyed {} jb_depth={} jitter={:.1f}ms late={} lost={} dup={} "
+             "frames={} deadline_miss={}",
+             id_hex, jitter.depth(), jitter.jitter_ms(),
+             jc.late_drops, jc.lost, jc.duplicates,
+             deadline_frames, deadline_misses);
+    }
 
-/* ================= UDP → STT ================= */
+    /**
+     * @brief 把会话重置为“刚构造”的状态，供会话池复用（在预热线程上调用）
+     *
+     * 解码器 / APM / WebRTC VAD 原地重置；TenVAD 没有重置接口，只能重建句柄。
+     */
+    void recycle() {
+        new_id();
+        addr = sockaddr_in{};
+        sockfd = -1;
+
+        opus_decoder_ctl(decoder, OPUS_RESET_STATE);
+        if (encoder) {
+            opus_encoder_ctl(encoder, OPUS_RESET_STATE);
+        }
+        apm->Initialize();
 
-void send_to_stt(const std::string& sid, const void* data, size_t len) {
-    static sockaddr_in stt_addr{};
-    static bool init = false;
+        if (webrtc_vad_inst) {
+            WebRtcVad_Init(webrtc_vad_inst);
+            WebRtcVad_set_mode(webrtc_vad_inst, g_config.read()->webrtc_vad_mode);
+        }
+        if (ten_vad) {
+            ten_vad_destroy(&ten_vad);
+            if (ten_vad_create(&ten_vad, kFrameSize, 0.5f) != 0) {
+                LOGE("[TenVAD] create failed");
+                ten_vad = nullptr;
+            }
+        }
+        std::fill(silero_state.begin(), silero_state.end(), 0.0f);
+        silero_fill = 0;
 
-    if (!init) {
-        stt_addr.sin_family = AF_INET;
-        stt_addr.sin_port   = htons(STT_PORT);
-        inet_pton(AF_INET, "127.0.0.1", &stt_addr.sin_addr);
-        init = true;
+        if (degrade_level != 0) {
+            set_degrade_level(0);
+        }
+        frames_since_step = 0;
+        config_version = 0;
+        profile_aec = true;
+        profile_ns  = true;
+        expired_udp    = false;
+        expired_speech = false;
+
+        jitter.clear();
+        last_packet_us = 0;
+        jitter_held.store(false, std::memory_order_relaxed);
+        carry_len = 0;
+        last_packet_samples = kFrameSize;
+
+        is_speaking    = false;
+        stt_started    = false;
+        silence_frames = 0;
+        stt_shm_gen    = 0;
+        stt_chunk_fill = 0;
+        preroll_head   = 0;
+        preroll_fill   = 0;
+        stt_opus_frame = 0;
+        stt_opus_seq   = 0;
+        stt_opus_ts    = 0;
+
+        frame_arrival_us = 0;
+        deadline_frames  = 0;
+        deadline_misses  = 0;
+
+        lane = nullptr;
+        if (mailbox) {
+            while (mailbox->front()) mailbox->pop();
+        }
+        scheduled.store(false, std::memory_order_relaxed);
     }
 
-    std::vector<uint8_t> buf(32 + len);
-    memcpy(buf.data(), sid.c_str(), 32);
-    memcpy(buf.data() + 32, data, len);
+    void new_id() {
+        session_id = SessionId::generate();
+        session_id.to_hex(id_hex);
+    }
 
-    sendto(g_sockfd, buf.data(), buf.size(), 0,
-           (sockaddr*)&stt_addr, sizeof(stt_addr));
-}
+    // 按 g_id_wire 选择的格式作为 STT 报文前缀
+    const void* wire_id() const {
+        return g_id_wire == IdWire::kHex ? static_cast<const void*>(id_hex)
+                                         : static_cast<const void*>(session_id.bytes);
+    }
 
-/* ================= VAD 状态机 ================= */
+    // 从池中取出交给新客户端时调用
+    void activate() {
+        last_active_time = time(nullptr);
+        last_speech_time.store(last_active_time, std::memory_order_relaxed);
+        g_level_sessions[0].fetch_add(1, std::memory_order_relaxed);
+    }
 
-void handle_vad_logic(
-    const std::shared_ptr<AudioSession>& s,
-    bool is_voice,
-    int16_t* pcm,
-    int silence_limit
-) {
-    if (is_voice) {
-        s->last_speech_time = time(nullptr);
+    // 某一降级级别对本会话的实际效果（叠加 profile 关掉的 APM 功能）
+    DegradeEffect effect_at(int level) const {
+        DegradeEffect e = degrade_effect(base_mode, level);
+        e.aec = e.aec && profile_aec;
+        e.ns  = e.ns && profile_ns;
+        return e;
+    }
 
-        if (!s->stt_started) {
-            send_to_stt(s->session_id, "start", 5);
-            s->stt_started = true;
-            LOGI("[VAD] start {}", s->session_id);
+    /**
+     * @brief 切换到指定降级级别（只能在处理本会话的线程上调用）
+     *
+     * 降级用到的 VAD 句柄按需创建，之后随会话一起复用；
+     * APM 配置切换走 ApplyConfig，APM 内部自带锁，流水线模式下跨线程调用也安全。
+     */
+    void set_degrade_level(int level) {
+        DegradeEffect from = effect_at(degrade_level);
+        DegradeEffect to   = effect_at(level);
+
+        if (to.vad != from.vad) {
+            ensure_vad(to.vad);
+            mode = to.vad;
+            silero_fill = 0;
+        }
+        if (to.ns != from.ns || to.aec != from.aec) {
+            auto rc = g_config.read();
+            apm->ApplyConfig(make_apm_config(*rc, to));
         }
 
-        s->is_speaking = true;
-        s->silence_frames = 0;
+        degrade_level = level;
     }
-    else if (s->is_speaking) {
-        if (++s->silence_frames >= silence_limit) {
-            send_to_stt(s->session_id, "end", 3);
-            s->stt_started = false;
-            s->is_speaking = false;
-            LOGI("[VAD] end {}", s->session_id);
+
+    void ensure_vad(VadMode m) {
+        if (m == VadMode::kWebRTC && !webrtc_vad_inst) {
+            webrtc_vad_inst = WebRtcVad_Create();
+            WebRtcVad_Init(webrtc_vad_inst);
+            WebRtcVad_set_mode(webrtc_vad_inst, g_config.read()->webrtc_vad_mode);
+        } else if (m == VadMode::kTenVad && !ten_vad) {
+            if (ten_vad_create(&ten_vad, kFrameSize, 0.5f) != 0) {
+                LOGE("[TenVAD] create failed");
+                ten_vad = nullptr;
+            }
+        } else if (m == VadMode::kSilero && silero_state.empty()) {
+            silero_state.assign(SileroVadDetector::kStateSize, 0.0f);
         }
     }
 
-    if (s->stt_started) {
-        send_to_stt(
-            s->session_id,
-            pcm,
-            kFrameSize * sizeof(int16_t)
-        );
+    /**
+     * @brief 帧边界：配置有新版本时套用到本会话（只在处理本会话的线程上调用）
+     *
+     * 阈值、静音判停、超时每帧直接从配置读取，这里只处理需要改动会话内句柄的项。
+     */
+    void apply_config(const RuntimeConfig& rc) {
+        if (config_version == rc.version) return;
+        config_version = rc.version;
+
+        if (webrtc_vad_inst) {
+            WebRtcVad_set_mode(webrtc_vad_inst, rc.webrtc_vad_mode);
+        }
+        apm->ApplyConfig(make_apm_config(rc, effect_at(degrade_level)));
     }
-}
 
-/* ================= 接收线程 ================= */
+    /**
+     * @brief 导出 / 导入会话状态（进程热交接，会话未在任何线程上运行时调用）
+     *
+     * 解码器内存由 opus_decoder_init 就地初始化、不含指针，整块拷贝即可；
+     * WebRTC VAD 实例同理。APM（AEC3 / NS）与 TenVAD 没有导出接口，只迁移配置，
+     * 内部自适应状态在新进程里从头收敛。
+     */
+    void save_state(handoff::SnapshotWriter& w) const {
+        w.put(int32_t(degrade_level));
+        w.blob(decoder_mem.get(), size_t(opus_decoder_get_size(1)));
 
-void receiver_processor_thread() {
-    uint8_t buffer[8192];
-    sockaddr_in cli_addr{};
-    socklen_t cli_len = sizeof(cli_addr);
+        if (webrtc_vad_inst) w.blob(webrtc_vad_inst, WebRtcVad_StateSize());
+        else                 w.blob(nullptr, 0);
 
-    StreamConfig sconf(kSampleRate, 1);
+        w.blob(silero_state.data(), silero_state.size() * sizeof(float));
+        w.put(int32_t(silero_fill));
+        w.bytes(silero_window, size_t(silero_fill) * sizeof(float));
 
-    while (true) {
-        ssize_t n = recvfrom(
-            g_sockfd,
-            buffer,
-            sizeof(buffer),
-            0,
-            (sockaddr*)&cli_addr,
-            &cli_len
-        );
-        if (n < 4) {
-            continue;
-        }
+        jitter.save(w);
 
-        /* ---------- 会话 key ---------- */
-        char ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &cli_addr.sin_addr, ip, sizeof(ip));
-        std::string key =
-            std::string(ip) + ":" + std::to_string(ntohs(cli_addr.sin_port));
+        w.put(int32_t(carry_len));
+        w.bytes(pcm_carry, size_t(carry_len) * sizeof(int16_t));
+        w.put(int32_t(last_packet_samples));
 
-        std::shared_ptr<AudioSession> sess;
+        w.put(uint8_t(is_speaking));
+        w.put(uint8_t(stt_started));
+        w.put(int32_t(silence_frames));
 
-        /* ---------- 会话获取 / 创建 ---------- */
-        {
-            std::lock_guard<std::mutex> lk(g_session_mu);
+        w.put(int64_t(last_active_time));
+        w.put(int64_t(last_speech_time.load(std::memory_order_relaxed)));
+        w.put(deadline_frames);
+        w.put(deadline_misses);
 
-            auto it = g_sessions.find(key);
-            if (it == g_sessions.end()) {
-                sess = std::make_shared<AudioSession>(g_vad_mode);
-                sess->addr = cli_addr;
+        w.put(uint8_t(profile_aec));
+        w.put(uint8_t(profile_ns));
 
-                g_sessions[key] = sess;
-                g_id_map[sess->session_id] = sess;
+        w.put(int32_t(stt_chunk_fill));
+        w.bytes(stt_chunk, size_t(stt_chunk_fill) * sizeof(int16_t));
 
-                LOGI("New session {} {}", key, sess->session_id);
-            } else {
-                sess = it->second;
+        w.put(int32_t(preroll_head));
+        w.put(int32_t(preroll_fill));
+        w.bytes(preroll, preroll_fill > 0 ? sizeof(preroll) : 0);
+
+        w.put(int32_t(stt_opus_frame));
+        w.put(stt_opus_seq);
+        w.put(stt_opus_ts);
+        if (stt_opus_frame > 0) w.blob(encoder_mem.get(), size_t(opus_encoder_get_size(1)));
+        else                    w.blob(nullptr, 0);
+
+        w.put(uint8_t(stt_shm_gen != 0));
+    }
+
+    // opus_ok：新旧进程的 libopus 版本与解码器大小一致，可以直接套用解码器内存
+    bool restore_state(handoff::SnapshotReader& r, bool opus_ok) {
+        int32_t level = 0;
+        r.get(level);
+        if (level > 0 && level <= kMaxDegradeLevel) {
+            set_degrade_level(level);
+        }
+
+        if (!(opus_ok && r.blob(decoder_mem.get(), size_t(opus_decoder_get_size(1))))) {
+            opus_decoder_init(decoder, kSampleRate, 1);
+        }
+
+        if (webrtc_vad_inst) {
+            if (!r.blob(webrtc_vad_inst, WebRtcVad_StateSize())) {
+                WebRtcVad_Init(webrtc_vad_inst);
+                WebRtcVad_set_mode(webrtc_vad_inst, g_config.read()->webrtc_vad_mode);
             }
+        } else {
+            r.blob(nullptr, 0);
+        }
 
-            sess->last_active_time = time(nullptr);
+        if (!r.blob(silero_state.data(), silero_state.size() * sizeof(float))) {
+            std::fill(silero_state.begin(), silero_state.end(), 0.0f);
+        }
+        int32_t fill = 0;
+        r.get(fill);
+        silero_fill = std::clamp(int(fill), 0, kSileroWindow);
+        r.bytes(silero_window, size_t(silero_fill) * sizeof(float));
+
+        jitter.restore(r);
+        jitter_held.store(jitter.buffered() > 0, std::memory_order_relaxed);
+
+        int32_t carry = 0, last_samples = kFrameSize;
+        r.get(carry);
+        carry_len = std::clamp(int(carry), 0, kFrameSize);
+        r.bytes(pcm_carry, size_t(carry_len) * sizeof(int16_t));
+        r.get(last_samples);
+        last_packet_samples = std::clamp(int(last_samples), 1, kMaxPacketSamples);
+
+        uint8_t speaking = 0, started = 0;
+        int32_t silence = 0;
+        r.get(speaking);
+        r.get(started);
+        r.get(silence);
+        is_speaking    = speaking != 0;
+        stt_started    = started != 0;
+        silence_frames = silence;
+
+        int64_t active = 0, speech = 0;
+        r.get(active);
+        r.get(speech);
+        last_active_time = time_t(active);
+        last_speech_time.store(time_t(speech), std::memory_order_relaxed);
+        r.get(deadline_frames);
+        r.get(deadline_misses);
+
+        // 旧版快照没有 profile 字段：保持默认（全部开启）
+        if (r.remaining() >= 2) {
+            uint8_t aec = 1, ns = 1;
+            r.get(aec);
+            r.get(ns);
+            profile_aec = aec != 0;
+            profile_ns  = ns != 0;
+        }
+        if (r.remaining() >= sizeof(int32_t)) {
+            int32_t fill = 0;
+            r.get(fill);
+            stt_chunk_fill = std::clamp(int(fill), 0, kMaxSttChunk);
+            r.bytes(stt_chunk, size_t(stt_chunk_fill) * sizeof(int16_t));
+        }
+        if (r.remaining() >= 2 * sizeof(int32_t)) {
+            int32_t head = 0, fill = 0;
+            r.get(head);
+            r.get(fill);
+            // fill > 0 时发送方总会写整个环：先读掉再校验，后面的字段才能对齐
+            if (fill > 0 && r.bytes(preroll, sizeof(preroll)) &&
+                head >= 0 && head < kMaxPreroll && head % kFrameSize == 0) {
+                preroll_head = head;
+                preroll_fill = std::min(int(fill), kMaxPreroll) / kFrameSize * kFrameSize;
+            }
+        }
+        if (r.remaining() >= sizeof(int32_t) + sizeof(uint16_t) + sizeof(uint32_t)) {
+            int32_t frame = 0;
+            r.get(frame);
+            r.get(stt_opus_seq);
+            r.get(stt_opus_ts);
+            bool valid = frame == kSampleRate / 100 || frame == kSampleRate / 50 ||
+                         frame == kSampleRate / 25  || frame == kSampleRate * 3 / 50;
+            if (valid && ensure_encoder()) {
+                stt_opus_frame = frame;
+                // 编码器无法迁移时本段剩余部分从头编码，STT 侧解码会有一次不连续
+                if (!(opus_ok && r.blob(encoder_mem.get(), size_t(opus_encoder_get_size(1))))) {
+                    if (!opus_ok) r.blob(nullptr, 0);
+                    reset_encoder(*g_config.read());
+                }
+            } else {
+                r.blob(nullptr, 0);
+            }
         }
+        // 本段锁定在共享内存：消费者代号只在旧进程内有效，新进程里永远对不上，
+        // 本段剩余部分按丢弃计，不改走 UDP（与消费者中途断开相同）
+        if (r.remaining() >= 1) {
+            uint8_t shm = 0;
+            r.get(shm);
+            stt_shm_gen = (shm != 0 && stt_started) ? UINT32_MAX : 0;
+        }
+
+        return r.ok();
+    }
+};
 
-        /* ---------- Opus 解码 ---------- */
-        uint16_t len = (buffer[0] << 8) | buffer[1];
+/* ================= 全局会话表 ================= */
 
-        int16_t near[kFrameSize];
-        int16_t ref[kFrameSize];
-        int16_t out[kFrameSize];
+// 只保护 g_id_map：仅在会话创建 / 过期 / AI 回包时加锁，收包热路径不碰
+std::mutex g_session_mu;
+std::unordered_map<SessionId, std::shared_ptr<AudioSession>, SessionIdHash> g_id_map;
+
+/* ================= 会话池 =================
+ *
+ * 新客户端不再现场构造 AudioSession（Opus 解码器 + 完整 APM + VAD 句柄），
+ * 而是从预热好的空闲会话里取一个：
+ * 1. 预热线程保持空闲数不低于目标值，呼叫高峰时新会话只是一次出栈
+ * 2. 会话最后一个引用释放后进入待回收队列，由预热线程写会话日志、原地重置后放回空闲列表，
+ *    超出保留上限的在预热线程上析构；释放方（worker / 调度线程）只做一次入队，
+ *    不承担日志 I/O、重置或析构开销
+ * 3. 池空时退回现场构造（计为 miss），不会拒绝新会话
+ */
+
+static constexpr int kMaxPoolSize = 65536;
+
+class SessionPool {
+public:
+    void configure(int target) {
+        target_ = target;
+        retain_ = std::max(target * 2, 64);
+        targets_[int(g_vad_mode)] = target;
+    }
 
-        if (opus_decode(
-                sess->decoder,
-                buffer + 2,
-                len,
-                near,
-                kFrameSize,
-                0) < 0)
+    std::shared_ptr<AudioSession> acquire(VadMode m) {
+        std::unique_ptr<AudioSession> s;
+        bool low = false;
         {
-            continue;
+            std::lock_guard<std::mutex> lk(mu_);
+            auto& fl = free_[int(m)];
+            if (!fl.empty()) {
+                s = std::move(fl.back());
+                fl.pop_back();
+            } else if (targets_[int(m)] < target_) {
+                // 非默认引擎按实际需求逐步加预热量：每 miss 一次多备一个，上限同默认引擎
+                ++targets_[int(m)];
+            }
+            low = int(fl.size()) < (targets_[int(m)] + 1) / 2;
         }
 
-        /* ---------- AEC + NS ---------- */
-        memset(ref, 0, sizeof(ref));
-        sess->apm->ProcessReverseStream(ref, sconf, sconf, nullptr);
-        sess->apm->ProcessStream(near, sconf, sconf, out);
-
-        /* ---------- VAD 分发 ---------- */
-        if (sess->mode == VadMode::kWebRTC) {
+        if (s) {
+            bump(hits_);
+        } else {
+            bump(misses_);
+            s = std::make_unique<AudioSession>(m);
+        }
+        if (low) {
+            cv_.notify_one();
+        }
 
-            bool is_voice =
-                (WebRtcVad_Process(
-                     sess->webrtc_vad_inst,
-                     kSampleRate,
-                     out,
-                     kFrameSize) == 1);
+        s->activate();
+        return std::shared_ptr<AudioSession>(
+            s.release(), [this](AudioSession* p) { release(p); });
+    }
 
-            handle_vad_logic(sess, is_voice, out, 50);
+    // 启动时同步预热，收包开始前池已就绪
+    void prewarm(VadMode m) {
+        for (int i = 0; i < targets_[int(m)]; ++i) {
+            put_free(std::make_unique<AudioSession>(m));
         }
-        else if (sess->mode == VadMode::kSilero) {
+    }
+
+    // 预热线程主循环
+    void warmer_loop() {
+        while (true) {
+            std::unique_ptr<AudioSession> dirty;
+            int warm = -1;   // 需要补充的引擎
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait_for(lk, std::chrono::seconds(1), [&] {
+                    return !dirty_.empty() || (warm = short_mode()) >= 0;
+                });
+                if (!dirty_.empty()) {
+                    dirty = std::move(dirty_.back());
+                    dirty_.pop_back();
+                } else {
+                    warm = short_mode();
+                }
+            }
 
-    // 1️⃣ int16 → float，累计到 512 samples
-    for (int i = 0; i < kFrameSize; ++i) {
-        sess->pcm_buffer.push_back(out[i] / 32768.0f);
+            if (dirty) {
+                dirty->log_summary();
+                dirty->recycle();
+                bump(recycled_);
+                put_free(std::move(dirty));
+            } else if (warm >= 0) {
+                put_free(std::make_unique<AudioSession>(VadMode(warm)));
+            }
+        }
     }
 
-    bool is_voice = false;
+    size_t free_count() {
+        std::lock_guard<std::mutex> lk(mu_);
+        size_t n = 0;
+        for (auto& fl : free_) n += fl.size();
+        return n;
+    }
 
-    // 2️⃣ Silero 固定 512 window
-    if (sess->pcm_buffer.size() >= 512) {
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    uint64_t recycled() const { return recycled_.load(std::memory_order_relaxed); }
 
-        is_voice = g_silero_vad->is_speech(
-            sess->pcm_buffer,
-            sess->silero_state   // 每 session 独立 RNN state
-        );
+private:
+    // 最后一个引用释放时调用（通常在 worker / 调度线程上）：只入队，
+    // 日志（同步落盘）与重置 / 析构都交给预热线程
+    void release(AudioSession* p) {
+        g_level_sessions[p->degrade_level].fetch_sub(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            dirty_.emplace_back(p);
+        }
+        cv_.notify_one();
+    }
 
-        sess->pcm_buffer.clear();
+    void put_free(std::unique_ptr<AudioSession> s) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto& fl = free_[int(s->base_mode)];
+            if (int(fl.size()) < retain_) {
+                fl.push_back(std::move(s));
+                return;
+            }
+        }
+        // 超出保留上限：s 在锁外析构
+    }
 
-        // 3️⃣ 进入统一 VAD 状态机
-        handle_vad_logic(sess, is_voice, out, 30);
+    // 空闲数低于目标的引擎（持锁调用），没有则返回 -1
+    int short_mode() const {
+        for (int m = 0; m < kVadModes; ++m) {
+            if (int(free_[m].size()) < targets_[m]) return m;
+        }
+        return -1;
     }
-    else if (sess->stt_started) {
-        // 4️⃣ 未满窗但已在说话，音频仍然要推给 STT
-        send_to_stt(
-            sess->session_id,
-            out,
-            sizeof(out)
-        );
+
+    static void bump(std::atomic<uint64_t>& c) {
+        c.fetch_add(1, std::memory_order_relaxed);
     }
-}
 
-        else if (sess->mode == VadMode::kTenVad) {
+    std::mutex              mu_;
+    std::condition_variable cv_;
+    std::vector<std::unique_ptr<AudioSession>> free_[kVadModes];   // 按 VadMode 分开
+    std::vector<std::unique_ptr<AudioSession>> dirty_;
 
-            bool is_voice = false;
+    int target_ = 0;                  // 默认引擎的预热量，也是其它引擎的上限
+    int targets_[kVadModes] = {};     // 各引擎当前预热目标
+    int retain_ = 64;
 
-            if (sess->ten_vad) {
-                float prob = 0.0f;
-                int flag = 0;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> recycled_{0};
+};
 
-                if (ten_vad_process(
-                        sess->ten_vad,
-                        out,
-                        kFrameSize,
-                        &prob,
-                        &flag) == 0)
-                {
-                    is_voice = (flag == 1);
+// 每个 NUMA 节点一个池（未启用绑核时只有一个），会话由本节点的预热线程构造，
+// APM / AEC3 等内部缓冲区因此落在本节点内存上
+std::vector<std::unique_ptr<SessionPool>> g_session_pools;
+int g_pool_size = 16;   // 预热空闲会话数（所有节点合计）
 
-                    // 如需调试概率，可打开
-                    // LOGI("[TenVAD] prob={}", prob);
-                }
-            }
+/* ================= 线程放置 =================
+ *
+ * -c 给出 CPU 列表（或 auto）时：worker 依次绑到列表中的核，调度线程接着往后取；
+ * 流水线 lane 与会话池预热线程绑到所属节点的全部核。每个被放置的线程把
+ * 内存策略设为优先本节点，之后它分配的内存就近落在本节点上。
+ */
 
-            handle_vad_logic(sess, is_voice, out, 30);
-        }
-    }
-}
+topo::Topology   g_topo;
+std::vector<int> g_cpus;   // 空 = 不绑核
+topo::HugePages  g_huge_pages = topo::HugePages::kOff;
 
+inline bool placement_enabled() { return !g_cpus.empty(); }
 
-/* ================= 清理线程 ================= */
+inline int cpu_for_slot(int slot) {
+    return placement_enabled() ? g_cpus[slot % g_cpus.size()] : -1;
+}
 
-void session_cleaner_thread() {
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(20));
-        time_t now = time(nullptr);
+void place_on_cpu(int cpu) {
+    if (cpu < 0) return;
+    topo::pin_to_cpus({cpu});
+    if (g_topo.nodes() > 1) topo::prefer_node(g_topo.node_of(cpu));
+}
 
-        std::lock_guard<std::mutex> lk(g_session_mu);
-        for (auto it = g_sessions.begin(); it != g_sessions.end();) {
-            auto& s = it->second;
-
-            bool udp_to =
-                (now - s->last_active_time) > SESSION_UDP_TIMEOUT_SEC;
-            bool sp_to =
-                (now - s->last_speech_time) > SESSION_SPEECH_TIMEOUT_SEC;
-
-            if (udp_to || sp_to) {
-                LOGW("Session {} timeout udp={} speech={}",
-                     s->session_id, udp_to, sp_to);
-                g_id_map.erase(s->session_id);
-                it = g_sessions.erase(it);
-            } else {
-                ++it;
-            }
-        }
-    }
+void place_on_node(int node) {
+    if (!placement_enabled()) return;
+    topo::pin_to_cpus(g_topo.node_cpus[node]);
+    if (g_topo.nodes() > 1) topo::prefer_node(node);
 }
 
-void ai_response_thread() {
+/* ================= Worker ================= */
 
-    int ai_sock = socket(AF_INET, SOCK_DGRAM, 0);
+static constexpr int kRecvBufSize  = 8192;
+static constexpr int kMaxRecvBatch = 64;
+static constexpr int kMaxWorkers   = 256;
+static constexpr int kWorkerWakeMs = 100;   // 空闲时的收包超时：醒来做会话过期与抖动缓冲排空
 
-    struct sockaddr_in ai_addr{};
+// 抖动缓冲排空扫描：会话停止收包超过 kJitterIdleUs 且缓冲里还有帧，才交给 JitterBuffer::drain 判断
+static constexpr int64_t kJitterScanUs = 20000;
+static constexpr int64_t kJitterIdleUs = 20000;
 
-    ai_addr.sin_family = AF_INET;
+/* ================= 流水线 =================
+ *
+ * 可选的分级模式：worker 线程只做 收包 → 抖动缓冲 → 解码 → 10ms 切块，
+ * APM 与 VAD 各自在独立线程上运行，级间用预分配 10ms 帧槽位的 SPSC 环连接。
+ * 每个 worker 有若干条 lane（APM 线程 + VAD 线程），会话创建时固定分到一条 lane，
+ * 因此单会话的帧顺序不变，Silero 推理变慢也不会阻塞收包。
+ */
 
-    ai_addr.sin_port = htons(8001);
+static constexpr size_t kLaneRingSize = 1024;   // 每级最多积压 1024 帧
+static constexpr int    kMaxLanes     = 16;
 
-    ai_addr.sin_addr.s_addr = INADDR_ANY;
+struct FrameSlot {
+    std::shared_ptr<AudioSession> sess;   // 帧在途期间会话不会被析构
+    int64_t arrival_us;                   // 会话里的值会被后续报文覆盖，随帧携带
+    int16_t pcm[kFrameSize];
+};
+
+struct PipelineLane {
+    SpscRing<FrameSlot> to_apm{kLaneRingSize};
+    SpscRing<FrameSlot> to_vad{kLaneRingSize};
 
-    if (bind(ai_sock, (struct sockaddr*)&ai_addr, sizeof(ai_addr)) < 0) return;
+    std::atomic<uint64_t> apm_busy_ns{0};
+    std::atomic<uint64_t> vad_busy_ns{0};
+    std::atomic<uint64_t> drops{0};       // APM 入口满，worker 侧丢帧
+};
 
+int g_pipeline_lanes = 0;   // 0 = 单线程串行处理
+
+/**
+ * 媒体处理计数（抖动缓冲 + 丢包补帧）。
+ * 每个执行媒体处理的线程（worker 或调度线程）各持一份：单线程写，统计线程读。
+ */
+struct MediaStats {
+    std::atomic<uint64_t> jb_late{0};
+    std::atomic<uint64_t> jb_dup{0};
+    std::atomic<uint64_t> jb_lost{0};
+    std::atomic<uint64_t> jb_frames{0};
+    std::atomic<uint64_t> jb_depth_sum{0};
+
+    std::atomic<uint64_t> fec_frames{0};
+    std::atomic<uint64_t> plc_frames{0};
+};
 
+// 会话过期定时器：key 用于摘表，sess 仅用于判断表中是否仍是同一个会话（不解引用）
+struct SessionTimer {
+    SessionKey    key;
+    AudioSession* sess = nullptr;
+};
 
-    char buf[4096];
+/**
+ * 每个 worker 独占一个 SO_REUSEPORT socket 与一份会话表。
+ * 内核按 4 元组哈希分发，同一客户端始终落在同一个 worker 上，
+ * 因此 sessions 只被本线程访问，无需加锁。
+ */
+static constexpr int kLatencyBuckets = 24;   // 桶 k 覆盖 [2^k, 2^(k+1)) us，最高约 8s
+
+int latency_bucket(int64_t us) {
+    int b = 0;
+    while (us > 1 && b < kLatencyBuckets - 1) {
+        us >>= 1;
+        ++b;
+    }
+    return b;
+}
 
-    while (true) {
+// 分位数取所在桶的上界；空直方图返回 0
+int64_t hist_percentile(const uint64_t* hist, double q) {
+    uint64_t total = 0;
+    for (int k = 0; k < kLatencyBuckets; ++k) total += hist[k];
+    if (total == 0) return 0;
 
-        ssize_t n = recvfrom(ai_sock, buf, sizeof(buf), 0, nullptr, nullptr);
+    uint64_t want = uint64_t(q * total), acc = 0;
+    for (int k = 0; k < kLatencyBuckets; ++k) {
+        acc += hist[k];
+        if (acc > want) return int64_t(1) << (k + 1);
+    }
+    return int64_t(1) << kLatencyBuckets;
+}
 
-        if (n < 32) continue;
+struct Worker {
+    int id = 0;
+    int sockfd = -1;
+    int cpu  = -1;   // -1 = 不绑核
+    int node = 0;
 
-        std::string sid(buf, 32);
+    FlatSessionTable<std::shared_ptr<AudioSession>> sessions;
+    TimerWheel<SessionTimer> timers{uint64_t(time(nullptr))};   // 1 tick = 1 秒
+    int64_t last_jitter_scan_us = 0;
 
-        std::string text(buf + 32, n - 32);
+    // 每次 recvmmsg 拿到的包数分布（下标 = 本批包数），由统计线程周期输出
+    std::atomic<uint64_t> batch_hist[kMaxRecvBatch + 1] = {};
+    std::atomic<size_t>   session_count{0};
 
+    MediaStats media;
 
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> allocs{0};          // 本线程累计堆分配（需 AEROSHELL_COUNT_ALLOCS）
 
-        std::lock_guard<std::mutex> lock(g_session_mu);
+    std::atomic<uint64_t> mailbox_drops{0};   // 调度器模式：会话邮箱满
 
-        if (g_id_map.count(sid)) {
+    // 流水线模式：各 lane 与 worker 自身（解码级）的忙碌时间
+    std::vector<std::unique_ptr<PipelineLane>> lanes;
+    int next_lane = 0;
+    std::atomic<uint64_t> busy_ns{0};
 
-            auto session = g_id_map[sid];
+    std::atomic<bool> parked{false};   // 进程热交接：已停止收包，会话表可被交接线程读取
 
-            sendto(g_sockfd, text.c_str(), text.size(), 0, (struct sockaddr*)&session->addr, sizeof(session->addr));
+    // 会话过期对收包循环造成的停顿：每次摘除了会话的 expire_sessions() 记一次
+    std::atomic<uint64_t> expired{0};
+    std::atomic<uint64_t> expire_ns{0};
+    std::atomic<uint64_t> expire_hist[kLatencyBuckets] = {};
 
-        }
+#ifdef AEROSHELL_WITH_IO_URING
+    std::unique_ptr<UringEngine> uring;
+#endif
+};
 
+std::vector<std::unique_ptr<Worker>> g_workers;
+int g_num_workers = 1;
+int g_recv_batch  = 1;   // 1 = 逐包 recvfrom，>1 = recvmmsg 批量接收
+
+// 单写者计数器：relaxed load + store，不需要 lock 前缀
+inline void bump(std::atomic<uint64_t>& c, uint64_t d = 1) {
+    c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+}
+
+// 把本线程的堆分配计数发布给统计线程；未开启计数时为空操作
+inline void publish_allocs(std::atomic<uint64_t>& c) {
+    if (alloc_counter::enabled()) {
+        c.store(alloc_counter::thread_count(), std::memory_order_relaxed);
     }
+}
 
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-/* ================= 日志初始化 ================= */
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-void log_init()
-{
-    ::mkdir("logs", 0755);
+// 作用域计时：析构时把耗时累加到单写者计数器，用于各级利用率统计
+struct ScopedBusy {
+    std::atomic<uint64_t>& acc;
+    int64_t t0 = now_ns();
+    ~ScopedBusy() { bump(acc, now_ns() - t0); }
+};
 
-    // 终端 sink
-    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+/* ---------- log2(us) 延迟直方图 ---------- */
+
+/* ---------- 逐帧实时性核算 ----------
+ *
+ * 每个 10ms 帧带上触发它的报文的到达时刻，VAD 判定 / STT 发送完成时与截止时间比较。
+ * 抖动缓冲为吸收乱序而主动保留的时间不计入（帧从被释放的那个报文到达时开始计时），
+ * 衡量的是网关自身的排队 + 解码 + APM + VAD 耗时。
+ * 计数器按线程各持一份（单写者），线程首次处理帧时登记，统计线程汇总。
+ */
+
+struct DeadlineStats {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> latency_hist[kLatencyBuckets] = {};   // 到达 → 完成
+    std::atomic<uint64_t> late_hist[kLatencyBuckets] = {};      // 超出截止时间的部分
+};
 
-    auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-        "logs/aeroshell_audio.log",
-        10 * 1024 * 1024, 
-        5                
-    );
+int64_t g_frame_deadline_us = 10000;
 
-    std::vector<spdlog::sink_ptr> sinks { file_sink };
+std::mutex g_deadline_mu;   // 只在线程登记与统计汇总时使用
+std::vector<std::unique_ptr<DeadlineStats>> g_deadline_stats;
+thread_local DeadlineStats* t_deadline = nullptr;
 
-    // 创建 logger
-    auto logger = std::make_shared<spdlog::logger>(
-        "aeroshell",
-        sinks.begin(),
-        sinks.end()
-    );
+DeadlineStats& thread_deadline_stats() {
+    if (!t_deadline) {
+        std::lock_guard<std::mutex> lk(g_deadline_mu);
+        g_deadline_stats.push_back(std::make_unique<DeadlineStats>());
+        t_deadline = g_deadline_stats.back().get();
+    }
+    return *t_deadline;
+}
 
-    spdlog::set_default_logger(logger);
+#ifdef AEROSHELL_WITH_IO_URING
+// 当前线程的 io_uring 引擎；非空时 STT / AI 回包走 SQE 批量提交
+thread_local UringEngine* t_uring = nullptr;
 
-    spdlog::set_level(spdlog::level::info);
-    spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+// 发送槽位按最大出站报文定长：AI 回包不超过一个接收缓冲区，STT 最大为 hex ID + 一个满聚合块。
+// 取最大值后整块 PCM 总能放进一个槽位，不必为大块回退到同步批次
+static constexpr size_t kMaxEgressMessage =
+    std::max<size_t>(kRecvBufSize, SessionId::kHexSize + kMaxSttChunk * sizeof(int16_t));
 
-    spdlog::flush_on(spdlog::level::info);
+std::unique_ptr<UringEngine> make_uring_engine() {
+    UringEngine::Config cfg;
+    cfg.recv_buf_size  = kRecvBufSize;
+    cfg.send_slot_size = unsigned(kMaxEgressMessage);
+    return std::make_unique<UringEngine>(cfg);
+}
+#endif
+
+/* ================= UDP → STT =================
+ *
+ * 同步路径下 STT 报文先暂存进本线程的 SendBatch，由处理线程在自然的批次边界
+ * （一轮 recvmmsg 处理完、流水线 / 调度线程队列空闲）统一 sendmmsg。
+ * SendBatch 没有定时器：忙碌的流水线 VAD 线程每帧、调度线程每个任务之后调 flush_stt_due()，
+ * 最早一条暂存满 1ms 就发出，排队时延的上界是 1ms 加一个处理单元的耗时。
+ * -b 1 的逐包 recvfrom 循环每包之后都 flush，攒批只对 -b >1、流水线与调度器模式有收益。
+ */
+
+std::mutex g_stt_batch_mu;
+std::vector<std::unique_ptr<SendBatch>> g_stt_batches;   // 按线程登记，统计线程汇总
+thread_local SendBatch* t_stt_batch = nullptr;
+
+SendBatch& thread_stt_batch() {
+    if (!t_stt_batch) {
+        std::lock_guard<std::mutex> lk(g_stt_batch_mu);
+        g_stt_batches.push_back(std::make_unique<SendBatch>(SendBatch::Config{}));
+        t_stt_batch = g_stt_batches.back().get();
+    }
+    return *t_stt_batch;
 }
 
-/* ================= main ================= */
+/* ---------- 同机 STT：共享内存环（-M） ----------
+ *
+ * 消费者连上 -M 的 Unix 域 socket 后，之后开始的语音段写共享内存环（布局见 SttShm.h），
+ * 没有消费者时照常走 UDP。出口在 start 时按段锁定，一段语音不会拆到两种出口上；
+ * 每个消费者一个代号，消费者断开或换人后，锁定到旧代号的语音段剩余部分丢弃。
+ * 环满时丢弃并计数，不阻塞处理线程。
+ */
+
+static constexpr size_t kSttShmBytes = 64u << 20;   // 约 2000 路并发说话 1 秒的 PCM
+
+std::string g_stt_shm_path;
+std::unique_ptr<SttShmRing> g_stt_shm;
+std::atomic<bool> g_stt_shm_attached{false};
+std::atomic<uint32_t> g_stt_shm_gen{0};   // 每接入一个消费者 +1
+
+enum class SttMsg : uint16_t {
+    kPcm   = STT_SHM_PCM,
+    kStart = STT_SHM_START,
+    kEnd   = STT_SHM_END,
+    kOpus  = STT_SHM_OPUS
+};
 
-int main(int argc, char* argv[]) {
-    log_init();
+// 依次服务消费者：发 fd，等连接断开，再接受下一个
+void stt_shm_listener_thread() {
+    int lfd = handoff::listen_unix(g_stt_shm_path);
+    if (lfd < 0) {
+        LOGE("[SttShm] cannot listen on {}: {}", g_stt_shm_path, strerror(errno));
+        return;
+    }
+    LOGI("[SttShm] waiting for STT reader on {} (ring {} MB)",
+         g_stt_shm_path, g_stt_shm->capacity() >> 20);
 
-    int opt;
-    while ((opt = getopt(argc, argv, "v:m:h")) != -1) {
-       if (opt == 'v') {
-    int v = std::stoi(optarg);
-    if (v == 1) g_vad_mode = VadMode::kWebRTC;
-    else if (v == 2) g_vad_mode = VadMode::kTenVad;
-    else g_vad_mode = VadMode::kSilero;
+    while (true) {
+        int conn = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno != EINTR) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        // 上一个消费者留下的积压不交给新消费者
+        uint32_t gen = g_stt_shm_gen.fetch_add(1, std::memory_order_release) + 1;
+        g_stt_shm->begin_epoch(gen);
+
+        if (!handoff::send_fds(conn, {g_stt_shm->memfd(), g_stt_shm->eventfd_fd()})) {
+            LOGW("[SttShm] failed to pass ring to reader");
+            close(conn);
+            continue;
+        }
+        g_stt_shm_attached.store(true, std::memory_order_release);
+        LOGI("[SttShm] reader attached, new STT segments go to shared memory");
+
+        // 消费者不会在这条连接上发数据：可读即对端关闭
+        handoff::wait_readable(conn, -1);
+        g_stt_shm_attached.store(false, std::memory_order_release);
+        close(conn);
+        LOGW("[SttShm] reader detached, new STT segments go to UDP");
+    }
 }
-        else if (opt == 'm')
-            g_model_path = optarg;
-        else {
-            LOGI("Usage: {} -v [0|1] -m [model_path]", argv[0]);
-            return 0;
+
+// 发出本线程暂存的 STT 报文
+void flush_stt() {
+    if (t_stt_batch && t_stt_batch->pending() > 0) {
+        t_stt_batch->flush();
+    }
+}
+
+// 忙碌时调用：只在最早一条暂存已满 max_delay_us 时发出
+void flush_stt_due() {
+    if (t_stt_batch) t_stt_batch->flush_if_due(now_us());
+}
+
+void send_to_stt(const AudioSession& s, SttMsg type, const void* data, size_t len) {
+    if (s.stt_shm_gen != 0) {
+        if (s.stt_shm_gen != g_stt_shm_gen.load(std::memory_order_acquire) ||
+            !g_stt_shm_attached.load(std::memory_order_relaxed)) {
+            if (g_stt_shm) g_stt_shm->note_dropped();   // 本段的消费者已断开：不改走 UDP
+            return;
         }
+        // start / end 在环里是记录类型，不带文本负载
+        bool audio = (type == SttMsg::kPcm || type == SttMsg::kOpus);
+        g_stt_shm->write(uint16_t(type), s.stt_shm_gen, s.session_id.bytes,
+                         audio ? data : nullptr, audio ? uint32_t(len) : 0);
+        return;
     }
 
-    g_sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(8000);
+    // 地址随配置热更新；调用方通常已在读区内，这里只是嵌套计数
+    auto rc = g_config.read();
+    const sockaddr_in& stt_addr = rc->stt_addr;
+
+#ifdef AEROSHELL_WITH_IO_URING
+    // 一旦回退到同步批次，本轮剩下的报文也进批次（poll 之后才 flush），否则后排队的
+    // SQE 会在下一次 poll 开头才提交，被批次里更早的报文反超（例如 end 赶在最后一块 PCM 前）
+    if (t_uring && !(t_stt_batch && t_stt_batch->pending() > 0)) {
+        if (t_uring->send(s.sockfd, stt_addr, s.wire_id(), id_wire_size(), data, len)) {
+            return;
+        }
+        t_uring->flush();   // 已排队的先进内核，再走同步路径
+    }
+#endif
+
+    // session_id 前缀与负载拷进本线程批次缓冲区，不分配
+    thread_stt_batch().stage(s.sockfd, stt_addr, s.wire_id(), id_wire_size(),
+                             data, len, now_us());
+}
 
-    if (g_vad_mode == VadMode::kSilero) {
-    SileroVadDetector::Config cfg;
-    cfg.model_path = g_model_path;
-    cfg.sample_rate = kSampleRate;
-    cfg.threshold = 0.5f;
+/* ================= 报文格式 =================
+ *
+ * legacy : [len:2][opus]                        —— 无序号，按到达顺序解码
+ * v1     : [0xAE][ver=1][seq:2][ts:4][len:2][opus]
+ *          seq 每包 +1，ts 为 16 kHz 采样点时间戳，多字节字段均为大端
+ *
+ * legacy 的首字节是长度高位，Opus 包不超过 1275 字节，首字节不会等于 0xAE。
+ */
+
+static constexpr uint8_t kPacketMagic   = 0xAE;
+static constexpr uint8_t kPacketVersion = 1;
+static constexpr uint8_t kPacketVersion2 = 2;
+static constexpr int     kV1HeaderSize  = 10;
+static constexpr int     kV2HeaderSize  = 11;
+
+/* ================= STT 出口 Opus 重编码 =================
+ *
+ * stt_codec = opus 时，APM 之后的干净 PCM 用会话自己的编码器压成 Opus 再发，
+ * 每个 Opus 帧一个报文：[会话 ID][v1 帧头][opus]，帧头与客户端上行 v1 报文相同（见上），
+ * STT 侧可以直接复用同一套解析与乱序处理。编码方式在 start 时锁定到本段语音结束：
+ * UDP 下该段的 start 负载为 "start:opus"，共享内存环里音频记录类型为 STT_SHM_OPUS。
+ * 24 kbit/s 时出口带宽约为 PCM（256 kbit/s）的 1/8，代价是每帧一次编码，
+ * CPU / 带宽取舍见 tools/stt_opus_bench.cpp。
+ */
+
+static constexpr int kSttOpusMaxPacket = 1275;   // Opus 单包上限
+
+// 编码计数按线程各持一份（单写者），线程首次编码时登记，统计线程汇总
+struct SttOpusStats {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> samples{0};     // 编码的输入样本数
+    std::atomic<uint64_t> bytes{0};       // 输出字节（含帧头，不含会话 ID）
+    std::atomic<uint64_t> encode_ns{0};
+    std::atomic<uint64_t> errors{0};
+};
 
-    g_silero_vad = std::make_unique<SileroVadDetector>(cfg);
+std::mutex g_stt_opus_mu;
+std::vector<std::unique_ptr<SttOpusStats>> g_stt_opus_stats;
+thread_local SttOpusStats* t_stt_opus = nullptr;
 
-    LOGI("[Silero] global model loaded: {}", g_model_path);
+SttOpusStats& thread_stt_opus_stats() {
+    if (!t_stt_opus) {
+        std::lock_guard<std::mutex> lk(g_stt_opus_mu);
+        g_stt_opus_stats.push_back(std::make_unique<SttOpusStats>());
+        t_stt_opus = g_stt_opus_stats.back().get();
+    }
+    return *t_stt_opus;
 }
 
-    if (bind(g_sockfd, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        LOGE("Bind failed: {}", strerror(errno));
-        return -1;
+void send_opus_frame(AudioSession& s, const int16_t* pcm, int samples) {
+    SttOpusStats& st = thread_stt_opus_stats();
+    uint8_t pkt[kV1HeaderSize + kSttOpusMaxPacket];
+
+    int64_t t0 = now_ns();
+    int n = opus_encode(s.encoder, pcm, samples, pkt + kV1HeaderSize, kSttOpusMaxPacket);
+    bump(st.encode_ns, now_ns() - t0);
+
+    if (n > 0) {
+        pkt[0] = kPacketMagic;
+        pkt[1] = kPacketVersion;
+        pkt[2] = uint8_t(s.stt_opus_seq >> 8);
+        pkt[3] = uint8_t(s.stt_opus_seq);
+        pkt[4] = uint8_t(s.stt_opus_ts >> 24);
+        pkt[5] = uint8_t(s.stt_opus_ts >> 16);
+        pkt[6] = uint8_t(s.stt_opus_ts >> 8);
+        pkt[7] = uint8_t(s.stt_opus_ts);
+        pkt[8] = uint8_t(n >> 8);
+        pkt[9] = uint8_t(n);
+        send_to_stt(s, SttMsg::kOpus, pkt, size_t(kV1HeaderSize + n));
+
+        bump(st.frames);
+        bump(st.samples, uint64_t(samples));
+        bump(st.bytes, uint64_t(kV1HeaderSize + n));
+    } else {
+        bump(st.errors);
     }
+    // 编码失败也推进序号与时间戳，STT 侧按丢包处理
+    ++s.stt_opus_seq;
+    s.stt_opus_ts += uint32_t(samples);
+}
 
-    std::thread(receiver_processor_thread).detach();
-    std::thread(session_cleaner_thread).detach();
-        // ai_response_thread 请自行根据您的 socket 需求补全
-     std::thread(ai_response_thread).detach();
+/* ================= STT 聚合 =================
+ *
+ * 10ms 帧先拷进会话的预分配块，攒满 stt_chunk_ms 再作为一个报文发出，
+ * 会话 ID 前缀摊到整块上。end 之前把不满一块的尾巴发出去，判停时延不受窗口影响。
+ * Opus 出口复用同一块缓冲攒编码帧（stt_chunk_ms 不生效）。
+ */
+
+void flush_stt_chunk(AudioSession& s) {
+    if (s.stt_chunk_fill == 0) return;
+    if (s.stt_opus_frame > 0) {
+        // Opus 只接受 10 / 20 / 40 / 60ms 帧：尾巴按放得下的最大帧长依次编码
+        for (int off = 0; off < s.stt_chunk_fill;) {
+            int left = s.stt_chunk_fill - off;
+            int n = left >= 4 * kFrameSize ? 4 * kFrameSize :
+                    left >= 2 * kFrameSize ? 2 * kFrameSize : kFrameSize;
+            send_opus_frame(s, s.stt_chunk + off, n);
+            off += n;
+        }
+    } else {
+        send_to_stt(s, SttMsg::kPcm, s.stt_chunk, size_t(s.stt_chunk_fill) * sizeof(int16_t));
+    }
+    s.stt_chunk_fill = 0;
+}
+
+void send_pcm_to_stt(AudioSession& s, const int16_t* pcm) {
+    if (s.stt_opus_frame > 0) {
+        if (s.stt_opus_frame == kFrameSize) {
+            send_opus_frame(s, pcm, kFrameSize);
+            return;
+        }
+        memcpy(s.stt_chunk + s.stt_chunk_fill, pcm, kFrameSize * sizeof(int16_t));
+        s.stt_chunk_fill += kFrameSize;
+        if (s.stt_chunk_fill >= s.stt_opus_frame) {
+            send_opus_frame(s, s.stt_chunk, s.stt_opus_frame);
+            s.stt_chunk_fill = 0;
+        }
+        return;
+    }
+
+    int chunk = g_config.read()->stt_chunk_ms * (kSampleRate / 1000);
+    if (chunk <= kFrameSize && s.stt_chunk_fill == 0) {
+        send_to_stt(s, SttMsg::kPcm, pcm, kFrameSize * sizeof(int16_t));   // 不聚合：直接发，免一次拷贝
+        return;
+    }
+
+    memcpy(s.stt_chunk + s.stt_chunk_fill, pcm, kFrameSize * sizeof(int16_t));
+    s.stt_chunk_fill += kFrameSize;
+    // 配置热更新把窗口改小时，已攒的超过新窗口也在这里发出
+    if (s.stt_chunk_fill >= chunk || s.stt_chunk_fill + kFrameSize > kMaxSttChunk) {
+        flush_stt_chunk(s);
+    }
+}
+
+/* ================= 起始前回看 =================
+ *
+ * VAD 判定有滞后（Silero 要攒满 512 样本窗），start 之前的起音会被截掉。
+ * 会话把未说话期间处理过的帧写进定长环，start 之后把最近 N ms 按时间顺序
+ * 逐帧交给 send_pcm_to_stt，随后才是触发帧。回看音频与实时音频走同一条聚合 / 编码路径，
+ * 报文大小不超过 stt_chunk_ms，也就不会因为放不进 io_uring 发送槽位而被实时音频反超。
+ * 不聚合（stt_chunk_ms = 10）时每帧以环内存为源直接交给 send_to_stt，没有聚合块这一次拷贝；
+ * 聚合时拷进聚合块是聚合本身的代价，与实时帧相同。
+ */
+
+int preroll_ms(const RuntimeConfig& rc, VadMode m) {
+    return m == VadMode::kSilero ? rc.preroll_silero_ms :
+           m == VadMode::kTenVad ? rc.preroll_tenvad_ms : rc.preroll_webrtc_ms;
+}
+
+void flush_preroll(AudioSession& s) {
+    int want = preroll_ms(*g_config.read(), s.mode) * (kSampleRate / 1000);
+    int n = std::min(want, s.preroll_fill) / kFrameSize * kFrameSize;
+
+    // 环内按 10ms 帧对齐，逐帧走正常发送路径
+    int start = (s.preroll_head - n + kMaxPreroll) % kMaxPreroll;
+    for (int i = 0; i < n; i += kFrameSize) {
+        send_pcm_to_stt(s, s.preroll + (start + i) % kMaxPreroll);
+    }
+    // 已发出或已过时：下一段语音从新的静音帧重新积累
+    s.preroll_fill = 0;
+}
+
+// start：锁定本段语音的出口（共享内存 / UDP）与编码，再补发起始前音频
+void begin_stt_segment(AudioSession& s) {
+    auto rc = g_config.read();
+    s.stt_shm_gen = g_stt_shm_attached.load(std::memory_order_acquire)
+                        ? g_stt_shm_gen.load(std::memory_order_acquire) : 0;
+    s.stt_opus_frame = 0;
+    if (rc->stt_opus && s.ensure_encoder()) {
+        s.reset_encoder(*rc);
+        s.stt_opus_frame = rc->stt_opus_frame_ms * (kSampleRate / 1000);
+        s.stt_opus_seq   = 0;
+        s.stt_opus_ts    = 0;
+        send_to_stt(s, SttMsg::kStart, "start:opus", 10);
+    } else {
+        send_to_stt(s, SttMsg::kStart, "start", 5);
+    }
+    flush_preroll(s);
+}
+
+/* ================= VAD 状态机 ================= */
+
+void handle_vad_logic(
+    AudioSession* s,
+    bool is_voice,
+    int16_t* pcm,
+    int silence_limit
+) {
+    if (is_voice) {
+        s->last_speech_time.store(time(nullptr), std::memory_order_relaxed);
+
+        if (!s->stt_started) {
+            begin_stt_segment(*s);
+            s->stt_started = true;
+            LOGI("[VAD] start {}", s->id_hex);
+        }
+
+        s->is_speaking = true;
+        s->silence_frames = 0;
+    }
+    else if (s->is_speaking) {
+        if (++s->silence_frames >= silence_limit) {
+            flush_stt_chunk(*s);
+            send_to_stt(*s, SttMsg::kEnd, "end", 3);
+            s->stt_started = false;
+            s->is_speaking = false;
+            LOGI("[VAD] end {}", s->id_hex);
+        }
+    }
+
+    if (s->stt_started) {
+        send_pcm_to_stt(*s, pcm);
+    }
+}
+
+/* ================= 报文解析 ================= */
+
+// v2 profile 字节：低 2 位选 VAD 引擎，bit2 / bit3 关闭 AEC / NS，其余保留
+static constexpr uint8_t kProfileVadMask = 0x03;
+static constexpr uint8_t kProfileNoAec   = 0x04;
+static constexpr uint8_t kProfileNoNs    = 0x08;
+
+struct MediaPacket {
+    uint8_t        profile = 0;       // v2 才有，legacy / v1 为 0（全部默认）
+    bool           has_seq = false;
+    uint16_t       seq     = 0;
+    uint32_t       ts      = 0;
+    const uint8_t* payload = nullptr;
+    size_t         len     = 0;
+};
+
+// profile 选择的 VAD 引擎；0 或引擎不可用（Silero 模型未加载）时用默认引擎
+VadMode profile_vad(const MediaPacket& pkt) {
+    switch (pkt.profile & kProfileVadMask) {
+    case 1:  return g_silero_vad ? VadMode::kSilero : g_vad_mode;
+    case 2:  return VadMode::kWebRTC;
+    case 3:  return VadMode::kTenVad;
+    default: return g_vad_mode;
+    }
+}
+
+bool parse_media_packet(const uint8_t* buf, ssize_t n, MediaPacket& pkt) {
+    if (n >= kV1HeaderSize && buf[0] == kPacketMagic) {
+        if (buf[1] == kPacketVersion2) {
+            // v2 = v1 头在 magic / ver 之后插入 1 字节 profile，跳过它后按 v1 解析
+            if (n < kV2HeaderSize) {
+                return false;
+            }
+            pkt.profile = buf[2];
+            ++buf;
+            --n;
+        } else if (buf[1] != kPacketVersion) {
+            return false;
+        }
+        pkt.has_seq = true;
+        pkt.seq     = uint16_t((buf[2] << 8) | buf[3]);
+        pkt.ts      = (uint32_t(buf[4]) << 24) | (uint32_t(buf[5]) << 16) |
+                      (uint32_t(buf[6]) << 8)  |  uint32_t(buf[7]);
+        pkt.len     = size_t((buf[8] << 8) | buf[9]);
+        pkt.payload = buf + kV1HeaderSize;
+        return pkt.len > 0 && pkt.len <= size_t(n - kV1HeaderSize);
+    }
+
+    if (n < 4) {
+        return false;
+    }
+    pkt.has_seq = false;
+    pkt.len     = size_t((buf[0] << 8) | buf[1]);
+    pkt.payload = buf + 2;
+    return pkt.len <= size_t(n - 2);
+}
+
+/* ================= 单帧处理：APM → VAD ================= */
+
+void apm_process(
+    AudioSession* sess,
+    const int16_t* near,
+    int16_t* out,
+    const StreamConfig& sconf
+) {
+    int16_t ref[kFrameSize];
+
+    /* ---------- AEC + NS ---------- */
+    memset(ref, 0, sizeof(ref));
+    sess->apm->ProcessReverseStream(ref, sconf, sconf, nullptr);
+    sess->apm->ProcessStream(near, sconf, sconf, out);
+}
+
+// 每帧检查一次会话是否需要沿降级阶梯移动一级
+void maybe_step_degrade(AudioSession* s) {
+    if (s->frames_since_step < kDegradeStepFrames) {
+        ++s->frames_since_step;
+        return;
+    }
+
+    int target = degrade_target(s->is_speaking);
+    int from = s->degrade_level;
+    if (target == from) {
+        return;
+    }
+
+    // 跨过对本会话没有实际效果的级别
+    int dir = (target > from) ? 1 : -1;
+    DegradeEffect cur = s->effect_at(from);
+    int next = from + dir;
+    while (next != target && s->effect_at(next) == cur) {
+        next += dir;
+    }
+
+    bool changed = !(s->effect_at(next) == cur);
+    s->set_degrade_level(next);
+    s->frames_since_step = 0;
+
+    g_level_sessions[from].fetch_sub(1, std::memory_order_relaxed);
+    g_level_sessions[next].fetch_add(1, std::memory_order_relaxed);
+
+    if (!changed) {
+        return;
+    }
+    if (dir > 0) {
+        g_degrade_down.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        g_degrade_up.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DegradeEffect e = s->effect_at(next);
+    LOGW("[Degrade] {} L{} -> L{} speaking={} vad={} ns={} aec={}",
+         s->id_hex, from, next, s->is_speaking, vad_name(e.vad), e.ns, e.aec);
+}
+
+// 帧处理完成（VAD 判定、需要时 STT 报文已交给出口）：与截止时间比较并记账。
+// 交给出口只是暂存进发送批次或排进 io_uring，之后到真正发出的等待不在计量之内
+void account_deadline(AudioSession* sess, int64_t arrival_us) {
+    if (arrival_us == 0) return;
+
+    DeadlineStats& ds = thread_deadline_stats();
+    int64_t latency = now_us() - arrival_us;
+
+    ++sess->deadline_frames;
+    bump(ds.frames);
+    bump(ds.latency_hist[latency_bucket(latency)]);
+
+    if (latency > g_frame_deadline_us) {
+        ++sess->deadline_misses;
+        bump(ds.misses);
+        bump(ds.late_hist[latency_bucket(latency - g_frame_deadline_us)]);
+    }
+}
+
+void vad_process(AudioSession* sess, int16_t* out, int64_t arrival_us) {
+    // 整帧使用同一份配置；新版本在这里（帧边界）生效
+    auto rc = g_config.read();
+    sess->apply_config(*rc);
+
+    maybe_step_degrade(sess);
+
+    /* ---------- VAD 分发 ---------- */
+    if (sess->mode == VadMode::kWebRTC) {
+
+        bool is_voice =
+            (WebRtcVad_Process(
+                 sess->webrtc_vad_inst,
+                 kSampleRate,
+                 out,
+                 kFrameSize) == 1);
+
+        handle_vad_logic(sess, is_voice, out, rc->webrtc_silence_frames);
+    }
+    else if (sess->mode == VadMode::kSilero) {
+
+        // 1️⃣ int16 → float，累计到 512 samples
+        float* dst = sess->silero_window + sess->silero_fill;
+        for (int i = 0; i < kFrameSize; ++i) {
+            dst[i] = out[i] / 32768.0f;
+        }
+        sess->silero_fill += kFrameSize;
+
+        bool is_voice = false;
+
+        // 2️⃣ Silero 固定 512 window
+        if (sess->silero_fill >= kSileroMinWindow) {
+
+            is_voice = g_silero_vad->speech_prob(
+                sess->silero_window,
+                size_t(sess->silero_fill),
+                sess->silero_state.data()   // 每 session 独立 RNN state
+            ) >= rc->silero_threshold;
+
+            sess->silero_fill = 0;
+
+            // 3️⃣ 进入统一 VAD 状态机
+            handle_vad_logic(sess, is_voice, out, rc->silero_silence_windows);
+        }
+        else if (sess->stt_started) {
+            // 4️⃣ 未满窗但已在说话，音频仍然要推给 STT
+            send_pcm_to_stt(*sess, out);
+        }
+    }
+    else if (sess->mode == VadMode::kTenVad) {
+
+        bool is_voice = false;
+
+        if (sess->ten_vad) {
+            float prob = 0.0f;
+            int flag = 0;
+
+            if (ten_vad_process(
+                    sess->ten_vad,
+                    out,
+                    kFrameSize,
+                    &prob,
+                    &flag) == 0)
+            {
+                // 阈值可热更新：按概率自行判定，flag 只对应创建句柄时的固定阈值
+                is_voice = (prob >= rc->tenvad_threshold);
+
+                // 如需调试概率，可打开
+                // LOGI("[TenVAD] prob={}", prob);
+            }
+        }
+
+        handle_vad_logic(sess, is_voice, out, rc->tenvad_silence_frames);
+    }
+
+    // 本帧没有发给 STT（未在说话）：留作下一次 start 的回看
+    if (!sess->stt_started) {
+        sess->preroll_push(out);
+    }
+
+    account_deadline(sess, arrival_us);
+}
+
+// 10ms 帧入口：串行模式直接处理，流水线模式投递到会话所属 lane
+void process_pcm(
+    AudioSession* sess,
+    const int16_t* near,
+    const StreamConfig& sconf
+) {
+    if (!sess->lane) {
+        int16_t out[kFrameSize];
+        apm_process(sess, near, out, sconf);
+        vad_process(sess, out, sess->frame_arrival_us);
+        return;
+    }
+
+    PipelineLane& lane = *sess->lane;
+
+    FrameSlot* slot = lane.to_apm.try_reserve();
+    if (!slot) {
+        bump(lane.drops);
+        return;
+    }
+    slot->sess = sess->shared_from_this();
+    slot->arrival_us = sess->frame_arrival_us;
+    memcpy(slot->pcm, near, sizeof(slot->pcm));
+    lane.to_apm.commit();
+}
+
+/* ================= 流水线级线程 ================= */
+
+// 空闲时先让出 CPU，持续空闲再短暂休眠，避免空转占满核
+void stage_idle(int& idle) {
+    if (++idle < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+void apm_stage_thread(PipelineLane* lane) {
+    StreamConfig sconf(kSampleRate, 1);
+    int idle = 0;
+
+    while (true) {
+        FrameSlot* in = lane->to_apm.front();
+        if (!in) {
+            stage_idle(idle);
+            continue;
+        }
+
+        // VAD 级积压时在这里等待（反压），丢帧只发生在 worker 入口，APM 状态保持连续
+        FrameSlot* out = lane->to_vad.try_reserve();
+        if (!out) {
+            stage_idle(idle);
+            continue;
+        }
+        idle = 0;
+
+        ScopedBusy busy{lane->apm_busy_ns};
+
+        apm_process(in->sess.get(), in->pcm, out->pcm, sconf);
+        out->sess = std::move(in->sess);
+        out->arrival_us = in->arrival_us;
+        lane->to_vad.commit();
+        lane->to_apm.pop();
+    }
+}
+
+void vad_stage_thread(PipelineLane* lane) {
+    int idle = 0;
+
+    while (true) {
+        FrameSlot* in = lane->to_vad.front();
+        if (!in) {
+            flush_stt();
+            stage_idle(idle);
+            continue;
+        }
+        idle = 0;
+
+        ScopedBusy busy{lane->vad_busy_ns};
+
+        vad_process(in->sess.get(), in->pcm, in->arrival_us);
+        in->sess.reset();
+        lane->to_vad.pop();
+        flush_stt_due();
+    }
+}
+
+/* ================= 解码 ================= */
+
+// 把任意时长的解码输出切成 10ms 块送入 APM / VAD
+void feed_pcm(
+    AudioSession* sess,
+    const int16_t* pcm,
+    int n,
+    const StreamConfig& sconf
+) {
+    int off = 0;
+
+    if (sess->carry_len > 0) {
+        int take = std::min(kFrameSize - sess->carry_len, n);
+        memcpy(sess->pcm_carry + sess->carry_len, pcm, take * sizeof(int16_t));
+        sess->carry_len += take;
+        off = take;
+
+        if (sess->carry_len < kFrameSize) {
+            return;
+        }
+        process_pcm(sess, sess->pcm_carry, sconf);
+        sess->carry_len = 0;
+    }
+
+    for (; n - off >= kFrameSize; off += kFrameSize) {
+        process_pcm(sess, pcm + off, sconf);
+    }
+
+    if (off < n) {
+        memcpy(sess->pcm_carry, pcm + off, (n - off) * sizeof(int16_t));
+        sess->carry_len = n - off;
+    }
+}
+
+void process_opus(
+    AudioSession* sess,
+    const uint8_t* payload,
+    size_t len,
+    const StreamConfig& sconf
+) {
+    // 任意合法帧长（2.5–60ms）与多帧包（最长 120ms）
+    int16_t pcm[kMaxPacketSamples];
+
+    int n = opus_decode(
+        sess->decoder,
+        payload,
+        len,
+        pcm,
+        kMaxPacketSamples,
+        0);
+    if (n <= 0) {
+        return;
+    }
+
+    sess->last_packet_samples = n;
+    feed_pcm(sess, pcm, n, sconf);
+}
+
+/**
+ * 丢包补帧：下一包带 LBRR 时用 in-band FEC 还原（decode_fec = 1），
+ * 否则走 Opus PLC（空包解码），保证下游 APM / VAD 始终按连续时钟运行。
+ *
+ * 连续丢多包时只有紧挨着下一包的那一帧能用 FEC，前面的都是 PLC。
+ */
+void recover_lost_frame(
+    MediaStats& ms,
+    AudioSession* sess,
+    const uint8_t* next,
+    size_t next_len,
+    const StreamConfig& sconf
+) {
+    int16_t pcm[kMaxPacketSamples];
+    int frame_size = sess->last_packet_samples;
+    int n;
+
+    // FEC 的 frame_size 取丢失时长；超出 LBRR 覆盖的部分由 libopus 内部做 PLC
+    if (next && opus_packet_has_lbrr(next, next_len) == 1) {
+        n = opus_decode(sess->decoder, next, next_len, pcm, frame_size, 1);
+        bump(ms.fec_frames);
+    } else {
+        n = opus_decode(sess->decoder, nullptr, 0, pcm, frame_size, 0);
+        bump(ms.plc_frames);
+    }
+
+    if (n > 0) {
+        feed_pcm(sess, pcm, n, sconf);
+    }
+}
+
+/* ================= 会话媒体处理：抖动缓冲 → 解码 ================= */
+
+void play_jitter_frame(
+    MediaStats& ms,
+    AudioSession* sess,
+    const JitterBuffer::Frame& f,
+    const StreamConfig& sconf
+) {
+    bump(ms.jb_frames);
+    bump(ms.jb_depth_sum, sess->jitter.depth());
+
+    if (f.lost) {
+        bump(ms.jb_lost);
+
+        const uint8_t* next = nullptr;
+        size_t next_len = 0;
+        sess->jitter.peek(uint16_t(f.seq + 1), next, next_len);
+
+        recover_lost_frame(ms, sess, next, next_len, sconf);
+        return;
+    }
+    process_opus(sess, f.data, f.len, sconf);
+}
+
+void process_media(
+    MediaStats& ms,
+    AudioSession* sess,
+    const MediaPacket& pkt,
+    int64_t arrival_us,
+    const StreamConfig& sconf
+) {
+    // 本次调用解码出的所有帧都以触发它的报文的到达时刻为起点
+    sess->frame_arrival_us = arrival_us;
+
+    if (!pkt.has_seq) {
+        process_opus(sess, pkt.payload, pkt.len, sconf);
+        return;
+    }
+
+    /* ---------- 抖动缓冲：按序号重排后再解码 ---------- */
+    switch (sess->jitter.push(pkt.seq, pkt.ts, pkt.payload, pkt.len, arrival_us)) {
+    case JitterBuffer::PushResult::kLate:      bump(ms.jb_late); break;
+    case JitterBuffer::PushResult::kDuplicate: bump(ms.jb_dup);  break;
+    default: break;
+    }
+
+    JitterBuffer::Frame f;
+    while (sess->jitter.pop(f)) {
+        play_jitter_frame(ms, sess, f, sconf);
+    }
+    sess->jitter_held.store(sess->jitter.buffered() > 0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 对端停发后排空抖动缓冲（在处理该会话媒体的线程上调用）
+ *
+ * 缓冲只靠后续到达推动出队，客户端不再发包时最后 depth 帧会一直留在缓冲里，
+ * 送不到 VAD / STT。会话空闲超过缓冲深度对应的时长后按序吐出剩余帧。
+ */
+void drain_jitter(MediaStats& ms, AudioSession* sess, const StreamConfig& sconf) {
+    int64_t now = now_us();
+    sess->frame_arrival_us = now;
+
+    JitterBuffer::Frame f;
+    while (sess->jitter.drain(f, now)) {
+        play_jitter_frame(ms, sess, f, sconf);
+    }
+    sess->jitter_held.store(sess->jitter.buffered() > 0, std::memory_order_relaxed);
+}
+
+/* ================= 会话调度器 =================
+ *
+ * 可选模式：worker 只收包并把报文投进会话邮箱，会话本身作为任务
+ * 在调度线程池上运行（工作窃取），忙会话与静默会话混合时各核负载自动摊平。
+ *
+ * 互斥：scheduled 标志为 true 表示会话已在队列中或正在运行，只有把它从 false
+ * 置为 true 的一方才提交任务，因此同一会话任何时刻最多在一个线程上运行。
+ */
+
+static constexpr int kMaxSchedThreads  = 256;
+static constexpr int kSessionRunBudget = 8;     // 单次最多处理的报文数，防止长邮箱饿死其它会话
+
+using SessionTask = std::shared_ptr<AudioSession>;
+
+// 调度线程私有上下文
+struct SchedThreadCtx {
+    MediaStats media;
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> latency_hist[kLatencyBuckets] = {};   // 报文到达 → 处理完成
+};
+
+int g_sched_threads = 0;   // 0 = 不启用，会话在所属 worker 上处理
+std::unique_ptr<WorkStealingScheduler<SessionTask>> g_scheduler;
+std::vector<std::unique_ptr<SchedThreadCtx>> g_sched_ctx;
+
+void enqueue_to_mailbox(
+    Worker& w,
+    AudioSession* sess,
+    const uint8_t* buffer,
+    ssize_t n,
+    int64_t arrival_us
+) {
+    PacketSlot* slot = sess->mailbox->try_reserve();
+    if (!slot || n > kMailboxPacketSize) {
+        bump(w.mailbox_drops);
+        return;
+    }
+
+    slot->arrival_us = arrival_us;
+    slot->len = uint16_t(n);
+    if (n > 0) memcpy(slot->data, buffer, n);
+    sess->mailbox->commit();
+
+    // seq_cst 交换：与 run_session 释放标志后的复查配对，避免丢失调度
+    if (!sess->scheduled.exchange(true, std::memory_order_seq_cst)) {
+        g_scheduler->submit(sess->shared_from_this(), size_t(w.id));
+    }
+}
+
+void run_session(SessionTask& task, int tid) {
+    thread_local StreamConfig sconf(kSampleRate, 1);
+
+    AudioSession* sess = task.get();
+    SchedThreadCtx& ctx = *g_sched_ctx[tid];
+
+    for (int i = 0; i < kSessionRunBudget; ++i) {
+        PacketSlot* p = sess->mailbox->front();
+        if (!p) break;
+
+        MediaPacket pkt;
+        if (p->len == 0) {
+            drain_jitter(ctx.media, sess, sconf);   // worker 投递的排空标记，不是报文
+        } else if (parse_media_packet(p->data, p->len, pkt)) {
+            process_media(ctx.media, sess, pkt, p->arrival_us, sconf);
+        }
+        bump(ctx.latency_hist[latency_bucket(now_us() - p->arrival_us)]);
+
+        sess->mailbox->pop();
+    }
+
+    publish_allocs(ctx.allocs);
+    flush_stt_due();
+
+    // 释放后复查：此时若邮箱非空且没人重新抢到标志，由本线程重新入队
+    sess->scheduled.store(false, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (sess->mailbox->size() > 0 &&
+        !sess->scheduled.exchange(true, std::memory_order_seq_cst)) {
+        g_scheduler->submit(std::move(task), size_t(tid));
+    }
+}
+
+/* ================= 单包处理 ================= */
+
+// 把会话挂到 worker 上：会话表、过期定时器、lane / 邮箱、全局 ID 表
+AudioSession* adopt_session(Worker& w, const SessionKey& key, std::shared_ptr<AudioSession> s) {
+    s->sockfd = w.sockfd;
+    if (!w.lanes.empty()) {
+        s->lane = w.lanes[w.next_lane++ % w.lanes.size()].get();
+    }
+    if (g_sched_threads > 0 && !s->mailbox) {
+        s->mailbox = std::make_unique<SpscRing<PacketSlot>>(kMailboxSlots);
+    }
+
+    AudioSession* raw = s.get();
+    w.timers.schedule({key, raw},
+                      uint64_t(raw->last_active_time) + g_config.read()->udp_timeout_sec + 1);
+    {
+        std::lock_guard<std::mutex> lk(g_session_mu);
+        g_id_map[raw->session_id] = s;
+    }
+    *w.sessions.try_emplace(key).first = std::move(s);
+    w.session_count.store(w.sessions.size(), std::memory_order_relaxed);
+    return raw;
+}
+
+void process_packet(
+    Worker& w,
+    const uint8_t* buffer,
+    ssize_t n,
+    const sockaddr_in& cli_addr,
+    int64_t arrival_us,
+    const StreamConfig& sconf
+) {
+    ScopedBusy busy{w.busy_ns};
+
+    MediaPacket pkt;
+    if (!parse_media_packet(buffer, n, pkt)) {
+        return;
+    }
+
+    /* ---------- 会话 key：二进制地址 + 端口，无字符串拼接 ---------- */
+    SessionKey key = SessionKey::from(cli_addr);
+
+    /* ---------- 会话获取 / 创建（worker 私有表，无锁） ---------- */
+    AudioSession* sess = nullptr;
+
+    if (auto* found = w.sessions.find(key)) {
+        sess = found->get();
+    } else {
+        // 只有建立会话的那个包的 profile 生效，之后的包不再改变引擎
+        VadMode mode = profile_vad(pkt);
+        auto created = g_session_pools[w.node]->acquire(mode);
+        created->addr = cli_addr;
+        created->profile_aec = !(pkt.profile & kProfileNoAec);
+        created->profile_ns  = !(pkt.profile & kProfileNoNs);
+        sess = adopt_session(w, key, std::move(created));
+        sess->apply_config(*g_config.read());
+
+        LOGI("New session {} {} worker={} vad={} aec={} ns={}", key.to_string(), sess->id_hex,
+             w.id, vad_name(mode), sess->profile_aec, sess->profile_ns);
+    }
+
+    sess->last_active_time = time(nullptr);
+    sess->last_packet_us   = arrival_us;
+    bump(w.packets);
+
+    if (g_scheduler) {
+        enqueue_to_mailbox(w, sess, buffer, n, arrival_us);
+    } else {
+        process_media(w.media, sess, pkt, arrival_us, sconf);
+    }
+    publish_allocs(w.allocs);
+}
+
+/* ================= 抖动缓冲排空 =================
+ *
+ * worker 每 kJitterScanUs 最多扫一遍本线程会话表（收包间隙或空闲超时醒来时），
+ * 停止收包的会话若缓冲里还有帧：直接处理模式下就地排空，
+ * 调度器模式下向邮箱投一个空标记，由持有会话的调度线程排空，会话仍只在一个线程上运行。
+ */
+
+void drain_idle_jitter(Worker& w, const StreamConfig& sconf) {
+    int64_t now = now_us();
+    if (now - w.last_jitter_scan_us < kJitterScanUs) {
+        return;
+    }
+    w.last_jitter_scan_us = now;
+
+    w.sessions.for_each([&](const SessionKey&, std::shared_ptr<AudioSession>& s) {
+        if (!s->jitter_held.load(std::memory_order_relaxed) ||
+            now - s->last_packet_us < kJitterIdleUs) {
+            return;
+        }
+        if (g_scheduler) {
+            if (s->mailbox->size() == 0) {
+                enqueue_to_mailbox(w, s.get(), nullptr, 0, now);
+            }
+        } else {
+            ScopedBusy busy{w.busy_ns};
+            drain_jitter(w.media, s.get(), sconf);
+        }
+    });
+}
+
+/* ================= 会话过期 =================
+ *
+ * 每个会话在所属 worker 的时间轮上挂一个定时器，到期时间取
+ * UDP 超时与说话超时中较早的一个。收包只刷新 last_active_time，不动定时器；
+ * 定时器触发时再按最新时间戳判断：未超时则按新的到期时间重新挂入（惰性续期），
+ * 因此每个会话每个超时周期最多被检查一次，过期延迟不超过 1 秒。
+ */
+
+uint64_t session_deadline(const AudioSession& s, const RuntimeConfig& rc) {
+    time_t udp = s.last_active_time + rc.udp_timeout_sec;
+    time_t sp  = s.last_speech_time.load(std::memory_order_relaxed) + rc.speech_timeout_sec;
+    // 超时判定为严格大于，故 +1
+    return uint64_t(std::min(udp, sp)) + 1;
+}
+
+// 在 worker 线程内推进时间轮；每摘除一个会话只短暂持一次全局锁（锁内只摘指针），
+// 会话的日志 / 重置 / 析构都在会话池的预热线程上完成
+void expire_sessions(Worker& w) {
+    time_t now = time(nullptr);
+    if (uint64_t(now) <= w.timers.now()) {
+        return;
+    }
+
+    int64_t t0 = now_ns();
+    uint64_t removed = 0;
+
+    // 超时热更新：改长由惰性续期自然生效；改短时已挂入的定时器仍按旧到期时间触发，触发时按新值判断
+    auto rc = g_config.read();
+
+    w.timers.advance(uint64_t(now), [&](SessionTimer& t) -> uint64_t {
+        auto* slot = w.sessions.find(t.key);
+        if (!slot || slot->get() != t.sess) {
+            return 0;   // 会话已被替换或移除
+        }
+
+        const auto& s = *slot;
+        bool udp_to =
+            (now - s->last_active_time) > rc->udp_timeout_sec;
+        bool sp_to =
+            (now - s->last_speech_time.load(std::memory_order_relaxed)) > rc->speech_timeout_sec;
+
+        if (!udp_to && !sp_to) {
+            return session_deadline(*s, *rc);
+        }
+
+        s->expired_udp    = udp_to;
+        s->expired_speech = sp_to;
+
+        std::shared_ptr<AudioSession> ref;
+        {
+            std::lock_guard<std::mutex> lk(g_session_mu);
+            auto it = g_id_map.find(s->session_id);
+            if (it != g_id_map.end()) {
+                ref = std::move(it->second);
+                g_id_map.erase(it);
+            }
+        }
+        ref.reset();
+        w.sessions.erase(t.key);   // 通常是最后一个引用：入会话池待回收队列
+        ++removed;
+        return 0;
+    });
+
+    w.session_count.store(w.sessions.size(), std::memory_order_relaxed);
+
+    if (removed > 0) {
+        int64_t ns = now_ns() - t0;
+        bump(w.expired, removed);
+        bump(w.expire_ns, uint64_t(ns));
+        bump(w.expire_hist[latency_bucket(ns / 1000)]);
+    }
+}
+
+/* ================= 进程热交接 =================
+ *
+ * -U <path>：新进程启动时先连接 path 上的旧进程；连上则接管，否则正常绑定端口。
+ * 启动完成后自己在 path 上监听，等待下一个版本来接管。
+ *
+ *   旧进程                                   新进程
+ *   accept ← ─────────────────────────────── connect（模型加载、会话池预热已完成）
+ *   冻结：worker 停止收包，流水线 / 邮箱排空
+ *   SCM_RIGHTS 发送各 worker socket + AI socket ─→
+ *   发送会话快照 ──────────────────────────────→ 恢复会话到同下标 worker
+ *                                    ←────────── 1 字节确认
+ *   退出                                      启动 worker，从内核队列继续收包
+ *
+ * 冻结期间到达的包留在内核 socket 接收队列里，由新进程接着处理，不丢包。
+ * 确认超时或连接断开时旧进程解冻继续服务，新进程放弃接管并退出。
+ */
+
+static constexpr uint32_t kSnapshotMagic     = 0x4f484541;   // "AEHO"
+static constexpr uint16_t kSnapshotVersion   = 1;
+static constexpr size_t   kMaxSnapshotBytes  = size_t(1) << 30;
+static constexpr int      kHandoffQuiesceMs  = 3000;    // worker 最长阻塞 kWorkerWakeMs（SO_RCVTIMEO）
+static constexpr int      kHandoffAckTimeoutMs = 30000;
+static constexpr uint8_t  kHandoffAck        = 0x06;
+
+std::string g_handoff_path;   // 空 = 不启用
+std::atomic<bool> g_handoff_freeze{false};
+int g_ai_sock = -1;
+
+// worker 每轮收包后调用：冻结期间停在这里，不再从 socket 取包
+void handoff_checkpoint(Worker& w) {
+    if (!g_handoff_freeze.load(std::memory_order_acquire)) return;
+
+    w.parked.store(true, std::memory_order_release);
+    while (g_handoff_freeze.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    w.parked.store(false, std::memory_order_release);
+}
+
+// 等所有 worker 停下、lane 与会话邮箱排空、调度线程上没有正在运行的会话
+bool handoff_quiesce() {
+    auto drained = [] {
+        for (auto& w : g_workers) {
+            if (!w->parked.load(std::memory_order_acquire)) return false;
+        }
+        for (auto& w : g_workers) {
+            for (auto& lane : w->lanes) {
+                if (lane->to_apm.size() > 0 || lane->to_vad.size() > 0) return false;
+            }
+            bool busy = false;
+            w->sessions.for_each([&](const SessionKey&, std::shared_ptr<AudioSession>& s) {
+                if ((s->mailbox && s->mailbox->size() > 0) ||
+                    s->scheduled.load(std::memory_order_acquire)) {
+                    busy = true;
+                }
+            });
+            if (busy) return false;
+        }
+        return true;
+    };
+
+    int64_t deadline = now_us() + int64_t(kHandoffQuiesceMs) * 1000;
+    while (!drained()) {
+        if (now_us() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::vector<uint8_t> build_snapshot(size_t& count) {
+    handoff::SnapshotWriter w;
+    const char* opus_ver = opus_get_version_string();
+
+    count = 0;
+    for (auto& wk : g_workers) count += wk->sessions.size();
+
+    w.put(kSnapshotMagic);
+    w.put(kSnapshotVersion);
+    w.blob(opus_ver, strlen(opus_ver));
+    w.put(uint32_t(opus_decoder_get_size(1)));
+    w.put(uint32_t(count));
+
+    for (auto& wk : g_workers) {
+        wk->sessions.for_each([&](const SessionKey&, std::shared_ptr<AudioSession>& s) {
+            size_t rec = w.begin_record();
+            w.put(uint16_t(wk->id));
+            w.bytes(s->session_id.bytes, SessionId::kSize);
+            w.put(s->addr);
+            w.put(uint8_t(s->base_mode));
+            s->save_state(w);
+            w.end_record(rec);
+        });
+    }
+    return w.data();
+}
+
+size_t restore_snapshot(const std::vector<uint8_t>& data) {
+    handoff::SnapshotReader r(data.data(), data.size());
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    r.get(magic);
+    r.get(version);
+    if (magic != kSnapshotMagic || version != kSnapshotVersion) {
+        LOGE("[Handoff] unsupported snapshot (magic={:#x} version={})", magic, version);
+        return 0;
+    }
+
+    uint32_t ver_len = 0, dec_size = 0, count = 0;
+    r.get(ver_len);
+    std::string opus_ver(std::min<size_t>(ver_len, r.remaining()), '\0');
+    r.bytes(opus_ver.data(), opus_ver.size());
+    r.get(dec_size);
+    r.get(count);
+
+    // 解码器内存布局随 libopus 版本变化，版本不同时解码器从头开始（只影响一两帧的 PLC 质量）
+    bool opus_ok = opus_ver == opus_get_version_string() &&
+                   dec_size == uint32_t(opus_decoder_get_size(1));
+    if (!opus_ok) {
+        LOGW("[Handoff] libopus changed ({} -> {}), decoders restart cold",
+             opus_ver, opus_get_version_string());
+    }
+
+    size_t restored = 0;
+    for (uint32_t i = 0; i < count && r.ok(); ++i) {
+        handoff::SnapshotReader rec = r.record();
+
+        uint16_t wid = 0;
+        SessionId id;
+        sockaddr_in addr{};
+        uint8_t mode = 0;
+        rec.get(wid);
+        rec.bytes(id.bytes, SessionId::kSize);
+        rec.get(addr);
+        rec.get(mode);
+        if (!rec.ok() || wid >= g_workers.size() || mode > uint8_t(VadMode::kTenVad)) {
+            continue;
+        }
+
+        // 会话保持原来的 VAD；本进程没加载 Silero 模型时改用本进程的 VAD
+        VadMode base = VadMode(mode);
+        if (base == VadMode::kSilero && !g_silero_vad) {
+            base = g_vad_mode;
+        }
+
+        Worker& w = *g_workers[wid];
+        auto s = g_session_pools[w.node]->acquire(base);
+        s->session_id = id;
+        id.to_hex(s->id_hex);
+        s->addr = addr;
+
+        if (!s->restore_state(rec, opus_ok)) {
+            LOGW("[Handoff] session {} snapshot truncated, partially restored", s->id_hex);
+        }
+        if (s->degrade_level != 0) {
+            g_level_sessions[0].fetch_sub(1, std::memory_order_relaxed);
+            g_level_sessions[s->degrade_level].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        adopt_session(w, SessionKey::from(addr), std::move(s));
+        ++restored;
+    }
+    return restored;
+}
+
+// 旧进程一侧：冻结 → 发送 socket 与快照 → 等待确认；失败时解冻继续服务
+bool serve_handoff(int conn) {
+    int64_t t0 = now_us();
+    g_handoff_freeze.store(true, std::memory_order_release);
+
+    if (!handoff_quiesce()) {
+        LOGW("[Handoff] workers did not drain in {} ms, aborting", kHandoffQuiesceMs);
+        g_handoff_freeze.store(false, std::memory_order_release);
+        return false;
+    }
+
+    size_t count = 0;
+    std::vector<uint8_t> snap = build_snapshot(count);
+
+    std::vector<int> fds;
+    for (auto& w : g_workers) fds.push_back(w->sockfd);
+    fds.push_back(g_ai_sock);
+
+    uint8_t ack = 0;
+    bool ok = handoff::send_fds(conn, fds) &&
+              handoff::send_blob(conn, snap) &&
+              handoff::wait_readable(conn, kHandoffAckTimeoutMs) &&
+              handoff::read_all(conn, &ack, 1) && ack == kHandoffAck;
+
+    if (!ok) {
+        LOGW("[Handoff] new process did not confirm, resuming service");
+        g_handoff_freeze.store(false, std::memory_order_release);
+        return false;
+    }
+
+    LOGI("[Handoff] handed over {} sockets and {} sessions ({} KB), frozen {} ms",
+         fds.size(), count, snap.size() / 1024, (now_us() - t0) / 1000);
+    return true;
+}
+
+void handoff_listener_thread() {
+    int lfd = handoff::listen_unix(g_handoff_path);
+    if (lfd < 0) {
+        LOGE("[Handoff] cannot listen on {}: {}", g_handoff_path, strerror(errno));
+        return;
+    }
+    LOGI("[Handoff] listening on {}", g_handoff_path);
+
+    while (true) {
+        int conn = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) continue;
+
+        if (serve_handoff(conn)) {
+            // socket 文件已归新进程所有，不 unlink；不走析构，避免会话归还时打日志 / 发 end
+            spdlog::shutdown();
+            std::_Exit(0);
+        }
+        close(conn);
+    }
+}
+
+/* ================= Worker 线程 ================= */
+
+void worker_thread(Worker* w) {
+    place_on_cpu(w->cpu);
+    StreamConfig sconf(kSampleRate, 1);
+
+#ifdef AEROSHELL_WITH_IO_URING
+    if (w->uring) {
+        t_uring = w->uring.get();
+        w->uring->add_recv(w->sockfd);
+
+        auto on_packet = [&](const uint8_t* data, size_t n, const sockaddr_in& from) {
+            process_packet(*w, data, n, from, now_us(), sconf);
+        };
+
+        while (true) {
+            // 回调里产生的 STT 发送在 poll 末尾统一提交
+            w->uring->poll(on_packet, kWorkerWakeMs);
+            drain_idle_jitter(*w, sconf);
+            flush_stt();   // 槽位用完后本轮回退到同步批次的报文
+            expire_sessions(*w);
+
+            if (g_handoff_freeze.load(std::memory_order_acquire)) {
+                // 先撤掉 multishot 接收并处理完已进缓冲区的包，之后的包留在内核队列里
+                w->uring->stop_recv();
+                while (w->uring->recv_active()) {
+                    w->uring->poll(on_packet, 100);
+                }
+                handoff_checkpoint(*w);
+                w->uring->add_recv(w->sockfd);
+            }
+        }
+    }
+#endif
+
+    if (g_recv_batch <= 1) {
+        uint8_t buffer[kRecvBufSize];
+        sockaddr_in cli_addr{};
+
+        while (true) {
+            socklen_t cli_len = sizeof(cli_addr);
+            ssize_t n = recvfrom(
+                w->sockfd,
+                buffer,
+                sizeof(buffer),
+                0,
+                (sockaddr*)&cli_addr,
+                &cli_len
+            );
+            if (n >= 0) {
+                process_packet(*w, buffer, n, cli_addr, now_us(), sconf);
+            }
+            drain_idle_jitter(*w, sconf);
+            flush_stt();
+            expire_sessions(*w);
+            handoff_checkpoint(*w);
+        }
+    }
+
+    /* ---------- recvmmsg 批量模式：缓冲区一次性预分配 ---------- */
+    // 接收缓冲区在本线程放置之后申请：落在本节点，可选大页
+    uint8_t* bufs = static_cast<uint8_t*>(topo::alloc_buffer(
+        size_t(g_recv_batch) * kRecvBufSize,
+        placement_enabled() ? w->node : -1,
+        g_huge_pages));
+    std::vector<sockaddr_in> addrs(g_recv_batch);
+    std::vector<iovec>       iovs(g_recv_batch);
+    std::vector<mmsghdr>     msgs(g_recv_batch);
+
+    for (int i = 0; i < g_recv_batch; ++i) {
+        iovs[i].iov_base = bufs + size_t(i) * kRecvBufSize;
+        iovs[i].iov_len  = kRecvBufSize;
+
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = &addrs[i];
+    }
+
+    while (true) {
+        for (int i = 0; i < g_recv_batch; ++i) {
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        }
+
+        // MSG_WAITFORONE：至少等到一个包，之后有多少拿多少，不为凑满批次而阻塞
+        int cnt = recvmmsg(w->sockfd, msgs.data(), g_recv_batch, MSG_WAITFORONE, nullptr);
+        if (cnt > 0) {
+            w->batch_hist[cnt].fetch_add(1, std::memory_order_relaxed);
+
+            // 整批共用一个到达时刻：批内靠后报文的排队时间也计入实时性核算
+            int64_t arrival_us = now_us();
+            for (int i = 0; i < cnt; ++i) {
+                process_packet(
+                    *w,
+                    static_cast<const uint8_t*>(iovs[i].iov_base),
+                    msgs[i].msg_len,
+                    addrs[i],
+                    arrival_us,
+                    sconf);
+            }
+        }
+        drain_idle_jitter(*w, sconf);
+        flush_stt();   // 整批产生的 STT 报文一次 sendmmsg
+        expire_sessions(*w);
+        handoff_checkpoint(*w);
+    }
+}
+
+/* ================= 降级控制器 =================
+ *
+ * 每秒采样一次所有处理线程（worker / 流水线 APM、VAD / 调度线程）的忙碌比例，
+ * 即单位时间内花在逐帧处理上的时间。最忙的线程超过高水位就把压力加一级；
+ * 低于低水位连续 kRestoreAfterSec 秒才减一级，恢复比降级慢，避免来回抖动。
+ */
+
+static constexpr int kRestoreAfterSec = 3;
+static constexpr int kDegradeHysteresisPct = 25;
+
+void load_controller_thread() {
+    std::vector<uint64_t> last;
+    int64_t last_wall = now_ns();
+    int calm = 0;
+
+    const int low_pct = std::max(g_degrade_high_pct - kDegradeHysteresisPct,
+                                 g_degrade_high_pct / 2);
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        int64_t wall = now_ns();
+        double wall_ns = double(wall - last_wall);
+        last_wall = wall;
+
+        size_t i = 0;
+        double max_util = 0.0;
+        auto sample = [&](uint64_t busy) {
+            if (last.size() <= i) last.push_back(busy);
+            max_util = std::max(max_util, 100.0 * double(busy - last[i]) / wall_ns);
+            last[i++] = busy;
+        };
+
+        for (auto& w : g_workers) {
+            sample(w->busy_ns.load(std::memory_order_relaxed));
+            for (auto& l : w->lanes) {
+                sample(l->apm_busy_ns.load(std::memory_order_relaxed));
+                sample(l->vad_busy_ns.load(std::memory_order_relaxed));
+            }
+        }
+        if (g_scheduler) {
+            for (int k = 0; k < g_scheduler->threads(); ++k) {
+                sample(g_scheduler->stats(k).busy_ns.load(std::memory_order_relaxed));
+            }
+        }
+
+        int p = g_pressure.load(std::memory_order_relaxed);
+        int next = p;
+        if (max_util > g_degrade_high_pct) {
+            next = std::min(p + 1, 2 * kMaxDegradeLevel);
+            calm = 0;
+        } else if (max_util < low_pct) {
+            if (p > 0 && ++calm >= kRestoreAfterSec) {
+                next = p - 1;
+                calm = 0;
+            }
+        } else {
+            calm = 0;
+        }
+
+        if (next != p) {
+            g_pressure.store(next, std::memory_order_relaxed);
+            LOGW("[Load] pressure {} -> {} max_util={:.0f}% target silent=L{} speaking=L{}",
+                 p, next, max_util, degrade_target(false), degrade_target(true));
+        }
+    }
+}
+
+/* ================= 统计线程 ================= */
+
+void stats_reporter_thread() {
+    uint64_t last[kMaxRecvBatch + 1] = {};
+    uint64_t last_jb[7] = {};
+    uint64_t last_pool[3] = {};
+    uint64_t last_expire[2] = {};
+    uint64_t last_stt[2] = {};
+    uint64_t last_shm[3] = {};
+    uint64_t last_opus[5] = {};
+    uint64_t last_expire_hist[kLatencyBuckets] = {};
+    uint64_t last_degrade[2] = {};
+    uint64_t last_deadline[2] = {};
+    uint64_t last_deadline_lat[kLatencyBuckets] = {};
+    uint64_t last_deadline_late[kLatencyBuckets] = {};
+
+    // 堆分配计数：每个 worker、每个调度线程各一项
+    std::vector<uint64_t> last_alloc(g_workers.size() + g_sched_ctx.size());
+    uint64_t last_alloc_total = 0, last_alloc_pkts = 0;
+
+    // 流水线各级累计忙碌时间：每个 worker 依次为 解码, (apm, vad) × lanes
+    std::vector<uint64_t> last_busy;
+    int64_t last_wall = now_ns();
+
+    // 调度线程：每线程 (runs, steals, busy_ns) 与延迟直方图上次快照
+    std::vector<std::array<uint64_t, 3>> last_sched(g_sched_threads);
+    std::vector<std::array<uint64_t, kLatencyBuckets>> last_lat(g_sched_threads);
+#ifdef AEROSHELL_WITH_IO_URING
+    uint64_t last_uring[3] = {};
+#endif
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(10));
+
+        std::string per_worker;
+        for (auto& w : g_workers) {
+            per_worker += " " + std::to_string(
+                w->session_count.load(std::memory_order_relaxed));
+        }
+        LOGI("[Stats] workers={} sessions/worker:{}", g_workers.size(), per_worker);
+
+        int64_t wall = now_ns();
+        double wall_ns = double(wall - last_wall);
+        last_wall = wall;
+
+        if (g_pipeline_lanes > 0) {
+            last_busy.resize(g_workers.size() * (1 + 2 * g_pipeline_lanes));
+            size_t bi = 0;
+            auto util = [&](const std::atomic<uint64_t>& busy) {
+                uint64_t cur = busy.load(std::memory_order_relaxed);
+                double u = 100.0 * double(cur - last_busy[bi]) / wall_ns;
+                last_busy[bi++] = cur;
+                return u;
+            };
+
+            for (auto& w : g_workers) {
+                double dec = util(w->busy_ns);
+                for (size_t k = 0; k < w->lanes.size(); ++k) {
+                    auto& l = *w->lanes[k];
+                    double apm = util(l.apm_busy_ns);
+                    double vad = util(l.vad_busy_ns);
+                    LOGI("[Stats] pipeline w{}.lane{} q_apm={} q_vad={} "
+                         "util decode={:.0f}% apm={:.0f}% vad={:.0f}% drops={}",
+                         w->id, k, l.to_apm.size(), l.to_vad.size(),
+                         dec, apm, vad, l.drops.load(std::memory_order_relaxed));
+                }
+            }
+        }
+
+        {
+            uint64_t cur[7] = {};
+            auto add = [&](const MediaStats& m) {
+                cur[0] += m.jb_late.load(std::memory_order_relaxed);
+                cur[1] += m.jb_dup.load(std::memory_order_relaxed);
+                cur[2] += m.jb_lost.load(std::memory_order_relaxed);
+                cur[3] += m.jb_frames.load(std::memory_order_relaxed);
+                cur[4] += m.jb_depth_sum.load(std::memory_order_relaxed);
+                cur[5] += m.fec_frames.load(std::memory_order_relaxed);
+                cur[6] += m.plc_frames.load(std::memory_order_relaxed);
+            };
+            for (auto& w : g_workers) add(w->media);
+            for (auto& c : g_sched_ctx) add(c->media);
+
+            uint64_t d[7];
+            for (int i = 0; i < 7; ++i) {
+                d[i] = cur[i] - last_jb[i];
+                last_jb[i] = cur[i];
+            }
+
+            if (d[3] > 0) {
+                LOGI("[Stats] jitter frames={} avg_depth={:.2f} late_drop={} dup={} lost={} "
+                     "fec={} plc={}",
+                     d[3], double(d[4]) / d[3], d[0], d[1], d[2], d[5], d[6]);
+            }
+        }
+
+        {
+            uint64_t cur[3] = {};
+            size_t free_count = 0;
+            for (auto& p : g_session_pools) {
+                cur[0] += p->hits();
+                cur[1] += p->misses();
+                cur[2] += p->recycled();
+                free_count += p->free_count();
+            }
+            if (cur[0] != last_pool[0] || cur[1] != last_pool[1] || cur[2] != last_pool[2]) {
+                LOGI("[Stats] pool free={} hits={} misses={} recycled={}",
+                     free_count, cur[0] - last_pool[0],
+                     cur[1] - last_pool[1], cur[2] - last_pool[2]);
+            }
+            for (int i = 0; i < 3; ++i) last_pool[i] = cur[i];
+        }
+
+        {
+            // 会话过期在收包线程上造成的停顿（每次摘除会话的 expire_sessions 调用计一次）
+            uint64_t cur[2] = {}, hist[kLatencyBuckets] = {};
+            for (auto& w : g_workers) {
+                cur[0] += w->expired.load(std::memory_order_relaxed);
+                cur[1] += w->expire_ns.load(std::memory_order_relaxed);
+                for (int k = 0; k < kLatencyBuckets; ++k) {
+                    hist[k] += w->expire_hist[k].load(std::memory_order_relaxed);
+                }
+            }
+
+            uint64_t d[kLatencyBuckets], calls = 0;
+            for (int k = 0; k < kLatencyBuckets; ++k) {
+                d[k] = hist[k] - last_expire_hist[k];
+                last_expire_hist[k] = hist[k];
+                calls += d[k];
+            }
+
+            if (calls > 0) {
+                LOGI("[Stats] expire sessions={} stalls={} stall_total={}us p50<{}us p99<{}us",
+                     cur[0] - last_expire[0], calls, (cur[1] - last_expire[1]) / 1000,
+                     hist_percentile(d, 0.50), hist_percentile(d, 0.99));
+            }
+            last_expire[0] = cur[0];
+            last_expire[1] = cur[1];
+        }
+
+        {
+            // STT 批量发送：报文数 - syscall 数 = 相对逐包 sendmsg 省下的 syscall
+            uint64_t cur[2] = {};
+            {
+                std::lock_guard<std::mutex> lk(g_stt_batch_mu);
+                for (auto& b : g_stt_batches) {
+                    cur[0] += b->stats().msgs.load(std::memory_order_relaxed);
+                    cur[1] += b->stats().syscalls.load(std::memory_order_relaxed);
+                }
+            }
+            uint64_t msgs = cur[0] - last_stt[0];
+            uint64_t calls = cur[1] - last_stt[1];
+            if (msgs > 0) {
+                LOGI("[Stats] stt_egress msgs={} syscalls={} avg_batch={:.1f} saved={:.0f}/s",
+                     msgs, calls, double(msgs) / std::max<uint64_t>(calls, 1),
+                     double(msgs - calls) * 1e9 / wall_ns);
+            }
+            last_stt[0] = cur[0];
+            last_stt[1] = cur[1];
+        }
+
+        {
+            // STT Opus 重编码：出口码率、相对 PCM 的压缩比与每 10ms 音频的编码耗时
+            uint64_t cur[5] = {};
+            {
+                std::lock_guard<std::mutex> lk(g_stt_opus_mu);
+                for (auto& o : g_stt_opus_stats) {
+                    cur[0] += o->frames.load(std::memory_order_relaxed);
+                    cur[1] += o->samples.load(std::memory_order_relaxed);
+                    cur[2] += o->bytes.load(std::memory_order_relaxed);
+                    cur[3] += o->encode_ns.load(std::memory_order_relaxed);
+                    cur[4] += o->errors.load(std::memory_order_relaxed);
+                }
+            }
+            uint64_t samples = cur[1] - last_opus[1];
+            if (samples > 0) {
+                uint64_t bytes = cur[2] - last_opus[2];
+                double audio_sec = double(samples) / kSampleRate;
+                LOGI("[Stats] stt_opus frames={} kbps={:.1f} ratio={:.1f}x encode={:.1f}us/10ms "
+                     "errors={}",
+                     cur[0] - last_opus[0], double(bytes) * 8 / audio_sec / 1000,
+                     double(samples) * sizeof(int16_t) / std::max<uint64_t>(bytes, 1),
+                     double(cur[3] - last_opus[3]) / 1000 / (double(samples) / kFrameSize),
+                     cur[4] - last_opus[4]);
+            }
+            for (int i = 0; i < 5; ++i) last_opus[i] = cur[i];
+        }
+
+        if (g_stt_shm) {
+            uint64_t cur[3] = {g_stt_shm->reserved_bytes(), g_stt_shm->dropped(),
+                               g_stt_shm->wakeups()};
+            if (cur[0] != last_shm[0] || cur[1] != last_shm[1]) {
+                LOGI("[Stats] stt_shm attached={} bytes={} backlog={} dropped={} wakeups={}",
+                     g_stt_shm_attached.load(std::memory_order_relaxed),
+                     cur[0] - last_shm[0], g_stt_shm->backlog_bytes(),
+                     cur[1] - last_shm[1], cur[2] - last_shm[2]);
+            }
+            for (int i = 0; i < 3; ++i) last_shm[i] = cur[i];
+        }
+
+        {
+            uint64_t down = g_degrade_down.load(std::memory_order_relaxed);
+            uint64_t up   = g_degrade_up.load(std::memory_order_relaxed);
+            int p = g_pressure.load(std::memory_order_relaxed);
+
+            if (p > 0 || down != last_degrade[0] || up != last_degrade[1]) {
+                std::string levels;
+                for (int l = 0; l <= kMaxDegradeLevel; ++l) {
+                    levels += " L" + std::to_string(l) + "=" + std::to_string(
+                        g_level_sessions[l].load(std::memory_order_relaxed));
+                }
+                LOGI("[Stats] degrade pressure={} down={} up={} sessions:{}",
+                     p, down - last_degrade[0], up - last_degrade[1], levels);
+            }
+            last_degrade[0] = down;
+            last_degrade[1] = up;
+        }
+
+        {
+            // 各线程计数只增不减、登记后不注销，汇总值单调，按差分输出本周期
+            uint64_t frames = 0, misses = 0;
+            uint64_t lat[kLatencyBuckets] = {}, late[kLatencyBuckets] = {};
+            {
+                std::lock_guard<std::mutex> lk(g_deadline_mu);
+                for (auto& ds : g_deadline_stats) {
+                    frames += ds->frames.load(std::memory_order_relaxed);
+                    misses += ds->misses.load(std::memory_order_relaxed);
+                    for (int k = 0; k < kLatencyBuckets; ++k) {
+                        lat[k]  += ds->latency_hist[k].load(std::memory_order_relaxed);
+                        late[k] += ds->late_hist[k].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            uint64_t d_frames = frames - last_deadline[0];
+            uint64_t d_misses = misses - last_deadline[1];
+            last_deadline[0] = frames;
+            last_deadline[1] = misses;
+            for (int k = 0; k < kLatencyBuckets; ++k) {
+                uint64_t l = lat[k], x = late[k];
+                lat[k]  -= last_deadline_lat[k];
+                late[k] -= last_deadline_late[k];
+                last_deadline_lat[k]  = l;
+                last_deadline_late[k] = x;
+            }
+
+            if (d_frames > 0) {
+                LOGI("[Stats] deadline {}us frames={} miss={} ({:.2f}%) "
+                     "latency p50<={}us p99<={}us late p50<={}us p99<={}us",
+                     g_frame_deadline_us, d_frames, d_misses,
+                     100.0 * double(d_misses) / double(d_frames),
+                     hist_percentile(lat, 0.50), hist_percentile(lat, 0.99),
+                     hist_percentile(late, 0.50), hist_percentile(late, 0.99));
+            }
+        }
+
+        if (alloc_counter::enabled()) {
+            uint64_t total = alloc_counter::total();
+            uint64_t pkts = 0;
+            std::string per_thread;
+
+            for (auto& w : g_workers) {
+                uint64_t a = w->allocs.load(std::memory_order_relaxed);
+                pkts += w->packets.load(std::memory_order_relaxed);
+                per_thread += " w" + std::to_string(w->id) + "=" +
+                              std::to_string(a - last_alloc[w->id]);
+                last_alloc[w->id] = a;
+            }
+            for (size_t i = 0; i < g_sched_ctx.size(); ++i) {
+                uint64_t a = g_sched_ctx[i]->allocs.load(std::memory_order_relaxed);
+                per_thread += " s" + std::to_string(i) + "=" +
+                              std::to_string(a - last_alloc[g_workers.size() + i]);
+                last_alloc[g_workers.size() + i] = a;
+            }
+
+            uint64_t d_pkts = pkts - last_alloc_pkts;
+            LOGI("[Stats] allocs total={} pkts={}{}", total - last_alloc_total, d_pkts, per_thread);
+            last_alloc_total = total;
+            last_alloc_pkts  = pkts;
+        }
+
+        if (g_scheduler) {
+            std::string per_thread;
+            uint64_t runs = 0, steals = 0, drops = 0;
+            uint64_t hist[kLatencyBuckets] = {};
+
+            for (int i = 0; i < g_scheduler->threads(); ++i) {
+                const auto& st = g_scheduler->stats(i);
+                uint64_t r  = st.runs.load(std::memory_order_relaxed);
+                uint64_t sl = st.steals.load(std::memory_order_relaxed);
+                uint64_t b  = st.busy_ns.load(std::memory_order_relaxed);
+                auto& ls = last_sched[i];
+
+                per_thread += " " + std::to_string(i) + ":q=" +
+                    std::to_string(g_scheduler->queued(i)) + "/util=" +
+                    std::to_string(int(100.0 * double(b - ls[2]) / wall_ns)) + "%";
+                runs   += r - ls[0];
+                steals += sl - ls[1];
+                ls[0] = r;
+                ls[1] = sl;
+                ls[2] = b;
+
+                for (int k = 0; k < kLatencyBuckets; ++k) {
+                    uint64_t c = g_sched_ctx[i]->latency_hist[k].load(std::memory_order_relaxed);
+                    hist[k] += c - last_lat[i][k];
+                    last_lat[i][k] = c;
+                }
+            }
+            for (auto& w : g_workers) {
+                drops += w->mailbox_drops.load(std::memory_order_relaxed);
+            }
+
+            uint64_t total = 0;
+            for (uint64_t c : hist) total += c;
+
+            LOGI("[Stats] sched runs={} steals={} mailbox_drops={} pkts={} "
+                 "latency p50<={}us p99<={}us threads:{}",
+                 runs, steals, drops, total,
+                 hist_percentile(hist, 0.50), hist_percentile(hist, 0.99), per_thread);
+        }
+
+        if (g_recv_batch > 1) {
+            uint64_t calls = 0, pkts = 0;
+            std::string hist;
+
+            for (int i = 1; i <= g_recv_batch; ++i) {
+                uint64_t cur = 0;
+                for (auto& w : g_workers) {
+                    cur += w->batch_hist[i].load(std::memory_order_relaxed);
+                }
+                uint64_t d = cur - last[i];
+                last[i] = cur;
+                if (d == 0) continue;
+
+                calls += d;
+                pkts  += d * i;
+                hist  += " " + std::to_string(i) + ":" + std::to_string(d);
+            }
+
+            if (calls > 0) {
+                LOGI("[Stats] recvmmsg calls={} pkts={} avg_batch={:.2f} hist{}",
+                     calls, pkts, double(pkts) / calls, hist);
+            }
+        }
+
+#ifdef AEROSHELL_WITH_IO_URING
+        if (g_io_engine == IoEngine::kUring) {
+            uint64_t recv = 0, sent = 0, submits = 0;
+            for (auto& w : g_workers) {
+                if (!w->uring) continue;
+                const auto& st = w->uring->stats();
+                recv    += st.recv_packets.load(std::memory_order_relaxed);
+                sent    += st.send_packets.load(std::memory_order_relaxed);
+                submits += st.submit_calls.load(std::memory_order_relaxed);
+            }
+
+            uint64_t d_recv = recv - last_uring[0];
+            uint64_t d_sent = sent - last_uring[1];
+            uint64_t d_sub  = submits - last_uring[2];
+            last_uring[0] = recv;
+            last_uring[1] = sent;
+            last_uring[2] = submits;
+
+            if (d_sub > 0) {
+                LOGI("[Stats] io_uring recv={} send={} submits={} pkts/submit={:.2f}",
+                     d_recv, d_sent, d_sub, double(d_recv + d_sent) / d_sub);
+            }
+        }
+#endif
+    }
+}
+
+
+/* ================= AI 回包 ================= */
+
+// 按报文头部的会话 ID 查找客户端地址；只在查表期间持锁
+bool lookup_ai_target(const char* buf, size_t n, int& fd, sockaddr_in& to) {
+    if (n < id_wire_size()) return false;
+
+    SessionId sid;
+    if (g_id_wire == IdWire::kHex) {
+        if (!SessionId::from_hex(buf, sid)) return false;
+    } else {
+        sid = SessionId::from_bytes(buf);
+    }
+
+    std::lock_guard<std::mutex> lock(g_session_mu);
+
+    auto it = g_id_map.find(sid);
+    if (it == g_id_map.end()) return false;
+
+    fd = it->second->sockfd;
+    to = it->second->addr;
+    return true;
+}
+
+int open_ai_socket() {
+
+    int ai_sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    struct sockaddr_in ai_addr{};
+
+    ai_addr.sin_family = AF_INET;
+
+    ai_addr.sin_port = htons(8001);
+
+    ai_addr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(ai_sock, (struct sockaddr*)&ai_addr, sizeof(ai_addr)) < 0) {
+        close(ai_sock);
+        return -1;
+    }
+    return ai_sock;
+}
+
+// ai_sock 由 main 绑定，或热交接时从旧进程继承
+void ai_response_thread(int ai_sock) {
+
+#ifdef AEROSHELL_WITH_IO_URING
+    if (g_io_engine == IoEngine::kUring) {
+        std::unique_ptr<UringEngine> uring;
+        try {
+            uring = make_uring_engine();
+        } catch (const std::exception& e) {
+            LOGE("[AI] io_uring unavailable, falling back to sockets: {}", e.what());
+        }
+
+        if (uring) {
+            uring->add_recv(ai_sock);
+
+            auto on_reply = [&](const uint8_t* data, size_t n, const sockaddr_in&) {
+                int fd;
+                sockaddr_in to;
+                const char* buf = reinterpret_cast<const char*>(data);
+                if (!lookup_ai_target(buf, n, fd, to)) return;
+
+                size_t hl = id_wire_size();
+                if (!uring->send(fd, to, nullptr, 0, buf + hl, n - hl)) {
+                    sendto(fd, buf + hl, n - hl, 0, (struct sockaddr*)&to, sizeof(to));
+                }
+            };
+
+            while (true) {
+                uring->poll(on_reply, 1000);
+            }
+        }
+    }
+#endif
+
+    char buf[4096];
+
+    while (true) {
+
+        ssize_t n = recvfrom(ai_sock, buf, sizeof(buf), 0, nullptr, nullptr);
+
+        int fd;
+        sockaddr_in to;
+        if (n < 0 || !lookup_ai_target(buf, n, fd, to)) continue;
+
+        size_t hl = id_wire_size();
+        sendto(fd, buf + hl, n - hl, 0, (struct sockaddr*)&to, sizeof(to));
+
+    }
+
+}
+
+/* ================= 日志初始化 ================= */
+
+void log_init()
+{
+    ::mkdir("logs", 0755);
+
+    // 终端 sink
+    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+    auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+        "logs/aeroshell_audio.log",
+        10 * 1024 * 1024, 
+        5                
+    );
+
+    std::vector<spdlog::sink_ptr> sinks { file_sink };
+
+    // 创建 logger
+    auto logger = std::make_shared<spdlog::logger>(
+        "aeroshell",
+        sinks.begin(),
+        sinks.end()
+    );
+
+    spdlog::set_default_logger(logger);
+
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+
+    spdlog::flush_on(spdlog::level::info);
+}
+
+/* ================= 拓扑 / 大页 ================= */
+
+/**
+ * 会话内部缓冲区（APM / AEC3、Opus、ORT）由各库自行 malloc，无法逐个改为大页内存；
+ * 改为让 glibc malloc 整体使用大页（glibc.malloc.hugetlb，glibc 2.35+）。
+ * 该参数只在进程启动时读取，因此设置环境变量后重新 exec 自身一次。
+ */
+void maybe_reexec_for_hugepages(char* argv[]) {
+    if (g_huge_pages == topo::HugePages::kOff || getenv("AEROSHELL_HUGEPAGE_REEXEC")) {
+        return;
+    }
+
+    const char* cur = getenv("GLIBC_TUNABLES");
+    if (cur && strstr(cur, "glibc.malloc.hugetlb")) {
+        return;   // 用户已自行指定
+    }
+
+    std::string want = (g_huge_pages == topo::HugePages::kExplicit)
+                           ? "glibc.malloc.hugetlb=2"
+                           : "glibc.malloc.hugetlb=1";
+    std::string tunables = (cur && *cur) ? std::string(cur) + ":" + want : want;
+
+    setenv("GLIBC_TUNABLES", tunables.c_str(), 1);
+    setenv("AEROSHELL_HUGEPAGE_REEXEC", "1", 1);
+    execv("/proc/self/exe", argv);
+
+    // 此时日志尚未初始化
+    fprintf(stderr, "[Topo] re-exec for malloc huge pages failed: %s\n", strerror(errno));
+}
+
+void log_topology() {
+    const char* tunables = getenv("GLIBC_TUNABLES");
+    LOGI("[Topo] nodes={} thp={} reserved_hugepages={} huge_pages={} GLIBC_TUNABLES={}",
+         g_topo.nodes(), topo::thp_mode(), topo::hugepages_reserved(),
+         g_huge_pages == topo::HugePages::kExplicit    ? "explicit" :
+         g_huge_pages == topo::HugePages::kTransparent ? "thp" : "off",
+         tunables ? tunables : "");
+
+    for (int n = 0; n < g_topo.nodes(); ++n) {
+        std::string cpus;
+        for (int c : g_topo.node_cpus[n]) cpus += " " + std::to_string(c);
+        LOGI("[Topo] node{} cpus:{}", n, cpus);
+    }
+
+    if (!placement_enabled()) {
+        LOGI("[Topo] thread pinning disabled (use -c)");
+        return;
+    }
+
+    for (auto& w : g_workers) {
+        LOGI("[Topo] worker {} cpu={} node={} lanes={} pool=node{}",
+             w->id, w->cpu, w->node, w->lanes.size(), w->node);
+    }
+    for (int i = 0; i < g_sched_threads; ++i) {
+        int cpu = cpu_for_slot(g_num_workers + i);
+        LOGI("[Topo] sched {} cpu={} node={}", i, cpu, g_topo.node_of(cpu));
+    }
+}
+
+/* ================= main ================= */
+
+/* ================= 配置热加载 =================
+ *
+ * SIGHUP 在所有线程中屏蔽，由本线程用 sigtimedwait 同步接收，不需要异步信号安全的处理函数。
+ * 新配置整体发布到 g_config，处理线程在下一帧开始时读到；旧对象等所有读者离开后回收。
+ */
+
+void reload_config() {
+    if (g_config_path.empty()) {
+        LOGW("[Config] SIGHUP ignored: no config file (-C)");
+        return;
+    }
+
+    auto next = std::make_unique<RuntimeConfig>();
+    std::string err;
+    if (!RuntimeConfig::load(g_config_path, *next, err)) {
+        LOGE("[Config] reload failed, keeping current config: {}", err);
+        return;
+    }
+
+    next->version = g_config.read()->version + 1;
+    LOGI("[Config] v{} loaded from {}: silence webrtc={} silero={} tenvad={} "
+         "threshold silero={} tenvad={} webrtc_mode={} timeout udp={}s speech={}s "
+         "aec={} ns={} ns_level={} stt={}:{} codec={} opus={}bps/{}ms/c{}",
+         next->version, g_config_path,
+         next->webrtc_silence_frames, next->silero_silence_windows, next->tenvad_silence_frames,
+         next->silero_threshold, next->tenvad_threshold, next->webrtc_vad_mode,
+         next->udp_timeout_sec, next->speech_timeout_sec,
+         next->apm_aec, next->apm_ns, next->apm_ns_level, next->stt_host, next->stt_port,
+         next->stt_opus ? "opus" : "pcm", next->stt_opus_bitrate, next->stt_opus_frame_ms,
+         next->stt_opus_complexity);
+    g_config.publish(std::move(next));
+}
+
+void config_reload_thread() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+
+    timespec tick{1, 0};
+    while (true) {
+        if (sigtimedwait(&set, nullptr, &tick) == SIGHUP) {
+            reload_config();
+        }
+        g_config.reclaim();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // 在创建任何线程之前屏蔽 SIGHUP，之后的线程都继承该掩码，只由配置线程接收
+    {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    }
+
+    std::string cpu_arg;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "v:m:b:w:e:p:s:n:i:c:H:D:d:U:C:M:h")) != -1) {
+       if (opt == 'v') {
+    int v = std::stoi(optarg);
+    if (v == 1) g_vad_mode = VadMode::kWebRTC;
+    else if (v == 2) g_vad_mode = VadMode::kTenVad;
+    else g_vad_mode = VadMode::kSilero;
+}
+        else if (opt == 'm')
+            g_model_path = optarg;
+        else if (opt == 'b')
+            g_recv_batch = std::clamp(std::stoi(optarg), 1, kMaxRecvBatch);
+        else if (opt == 'w')
+            g_num_workers = std::clamp(std::stoi(optarg), 1, kMaxWorkers);
+        else if (opt == 'p')
+            g_pipeline_lanes = std::clamp(std::stoi(optarg), 0, kMaxLanes);
+        else if (opt == 's')
+            g_sched_threads = std::clamp(std::stoi(optarg), 0, kMaxSchedThreads);
+        else if (opt == 'n')
+            g_pool_size = std::clamp(std::stoi(optarg), 0, kMaxPoolSize);
+        else if (opt == 'i')
+            g_id_wire = (std::string(optarg) == "hex") ? IdWire::kHex : IdWire::kBinary;
+        else if (opt == 'c')
+            cpu_arg = optarg;
+        else if (opt == 'D')
+            g_degrade_high_pct = std::clamp(std::stoi(optarg), 0, 100);
+        else if (opt == 'd')
+            g_frame_deadline_us = int64_t(std::clamp(std::stod(optarg), 0.1, 1000.0) * 1000);
+        else if (opt == 'U')
+            g_handoff_path = optarg;
+        else if (opt == 'C')
+            g_config_path = optarg;
+        else if (opt == 'M')
+            g_stt_shm_path = optarg;
+        else if (opt == 'H') {
+            std::string h = optarg;
+            g_huge_pages = (h == "explicit") ? topo::HugePages::kExplicit :
+                           (h == "thp")      ? topo::HugePages::kTransparent :
+                                               topo::HugePages::kOff;
+        }
+        else if (opt == 'e')
+            g_io_engine = (std::string(optarg) == "uring") ? IoEngine::kUring
+                                                           : IoEngine::kSocket;
+        else {
+            LOGI("Usage: {} -v [0|1|2] -m [model_path] -b [recv_batch 1-{}] -w [workers 1-{}] "
+                 "-e [socket|uring] -p [pipeline lanes 0-{}] -s [scheduler threads 0-{}] "
+                 "-n [pre-warmed sessions 0-{}] -i [bin|hex] -c [cpu list|auto] "
+                 "-H [off|thp|explicit] -D [degrade high-water % 0-100, 0=off] "
+                 "-d [frame deadline ms, default 10] -U [handoff unix socket path] "
+                 "-C [runtime config file, reloaded on SIGHUP] "
+                 "-M [unix socket path for a co-located STT shared-memory reader]",
+                 argv[0], kMaxRecvBatch, kMaxWorkers, kMaxLanes, kMaxSchedThreads,
+                 kMaxPoolSize);
+            return 0;
+        }
+    }
+
+#ifndef AEROSHELL_WITH_IO_URING
+    if (g_io_engine == IoEngine::kUring) {
+        LOGE("io_uring engine requested but this build has no liburing support");
+        return -1;
+    }
+#endif
+
+    // 流水线 lane 按 worker 固定绑定会话，调度器按会话动态派发，两者不能同时启用
+    if (g_sched_threads > 0 && g_pipeline_lanes > 0) {
+        LOGE("-s (scheduler) and -p (pipeline lanes) are mutually exclusive");
+        return -1;
+    }
+
+    if (!g_config_path.empty()) {
+        auto cfg = std::make_unique<RuntimeConfig>();
+        std::string err;
+        if (!RuntimeConfig::load(g_config_path, *cfg, err)) {
+            LOGE("[Config] {}", err);
+            return -1;
+        }
+        g_config.publish(std::move(cfg));
+        g_config.reclaim();
+    }
+
+    // 大页需要 re-exec：放在 log_init 之前，日志文件的 fd 不会带进新映像。
+    // 此前的参数 / 配置错误走 spdlog 默认的终端输出
+    maybe_reexec_for_hugepages(argv);
+    log_init();
+
+    g_topo = topo::Topology::detect();
+    if (!cpu_arg.empty()) {
+        try {
+            g_cpus = (cpu_arg == "auto") ? g_topo.spread() : topo::parse_list(cpu_arg);
+        } catch (const std::exception&) {
+            LOGE("invalid cpu list: {}", cpu_arg);
+            return -1;
+        }
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(8000);
+
+    {
+        // 会话可以通过 profile 选 Silero，所以无论 -v 是什么都尝试加载；
+        // 只有默认引擎就是 Silero 时加载失败才致命，否则这些会话回退到默认引擎
+        SileroVadDetector::Config cfg;
+        cfg.model_path = g_model_path;
+        cfg.sample_rate = kSampleRate;
+        cfg.threshold = g_config.read()->silero_threshold;
+
+        try {
+            g_silero_vad = std::make_unique<SileroVadDetector>(cfg);
+            LOGI("[Silero] global model loaded: {}", g_model_path);
+        } catch (const std::exception& e) {
+            if (g_vad_mode == VadMode::kSilero) {
+                LOGE("[Silero] failed to load {}: {}", g_model_path, e.what());
+                return -1;
+            }
+            LOGW("[Silero] model {} not loaded ({}), Silero profiles fall back to {}",
+                 g_model_path, e.what(), vad_name(g_vad_mode));
+        }
+    }
+
+    if (!g_stt_shm_path.empty()) {
+        std::string err;
+        g_stt_shm = SttShmRing::create(kSttShmBytes, kSampleRate, err);
+        if (!g_stt_shm) {
+            LOGE("[SttShm] cannot create ring: {}", err);
+            return -1;
+        }
+    }
+
+    {
+        // 每个节点的池由绑在该节点上的线程预热，预热完成后该线程转为回收 / 补充线程
+        auto t0 = std::chrono::steady_clock::now();
+        int pools = placement_enabled() ? g_topo.nodes() : 1;
+        int per_pool = (g_pool_size + pools - 1) / pools;
+
+        std::vector<std::future<void>> warmed;
+        for (int k = 0; k < pools; ++k) {
+            g_session_pools.push_back(std::make_unique<SessionPool>());
+            SessionPool* pool = g_session_pools.back().get();
+            pool->configure(per_pool);
+
+            auto ready = std::make_shared<std::promise<void>>();
+            warmed.push_back(ready->get_future());
+            std::thread([pool, k, ready] {
+                place_on_node(k);
+                pool->prewarm(g_vad_mode);
+                ready->set_value();
+                pool->warmer_loop();
+            }).detach();
+        }
+        for (auto& f : warmed) f.wait();
+
+        LOGI("[Pool] pre-warmed {} sessions ({} pool(s)) in {} ms", per_pool * pools, pools,
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - t0).count());
+    }
+
+    // 热交接：模型与会话池都准备好之后才连接旧进程，缩短旧进程的冻结时间
+    int handoff_conn = -1;
+    std::vector<int> inherited;
+    std::vector<uint8_t> snapshot;
+
+    if (!g_handoff_path.empty()) {
+        handoff_conn = handoff::connect_unix(g_handoff_path);
+    }
+    if (handoff_conn >= 0) {
+        if (!handoff::recv_fds(handoff_conn, inherited) || inherited.size() < 2 ||
+            !handoff::recv_blob(handoff_conn, snapshot, kMaxSnapshotBytes)) {
+            LOGE("[Handoff] takeover via {} failed", g_handoff_path);
+            return -1;
+        }
+
+        // 沿用旧进程的 reuseport 组：worker 数必须与继承的 socket 数一致，客户端才落在同一下标
+        int n = int(inherited.size()) - 1;
+        if (n != g_num_workers) {
+            LOGW("[Handoff] -w {} overridden by {} inherited sockets", g_num_workers, n);
+            g_num_workers = n;
+        }
+        g_ai_sock = inherited.back();
+    } else {
+        g_ai_sock = open_ai_socket();
+        if (g_ai_sock < 0) {
+            LOGE("AI socket bind failed: {}", strerror(errno));
+            return -1;
+        }
+    }
+
+    // 每个 worker 一个 SO_REUSEPORT socket，全部绑定在 8000 端口
+    for (int i = 0; i < g_num_workers; ++i) {
+        auto w = std::make_unique<Worker>();
+        w->id = i;
+        w->cpu = cpu_for_slot(i);
+        w->node = placement_enabled() ? g_topo.node_of(w->cpu) : 0;
+
+        if (handoff_conn >= 0) {
+            // 继承的 socket 已绑定、选项已设置
+            w->sockfd = inherited[i];
+        } else {
+            w->sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+
+            int one = 1;
+            setsockopt(w->sockfd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+            if (bind(w->sockfd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                LOGE("Bind failed: {}", strerror(errno));
+                return -1;
+            }
+        }
+
+        // 空闲时也要定期醒来做会话过期与抖动缓冲排空；继承的 socket 也按本版本的周期重设
+        timeval tv{0, kWorkerWakeMs * 1000};
+        setsockopt(w->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+#ifdef AEROSHELL_WITH_IO_URING
+        if (g_io_engine == IoEngine::kUring) {
+            try {
+                w->uring = make_uring_engine();
+            } catch (const std::exception& e) {
+                LOGE("[Uring] worker {} init failed: {}", i, e.what());
+                return -1;
+            }
+        }
+#endif
+        for (int k = 0; k < g_pipeline_lanes; ++k) {
+            w->lanes.push_back(std::make_unique<PipelineLane>());
+        }
+        g_workers.push_back(std::move(w));
+    }
+
+    if (g_sched_threads > 0) {
+        for (int i = 0; i < g_sched_threads; ++i) {
+            g_sched_ctx.push_back(std::make_unique<SchedThreadCtx>());
+        }
+        g_scheduler = std::make_unique<WorkStealingScheduler<SessionTask>>(
+            g_sched_threads, run_session);
+        g_scheduler->start([](int i) { place_on_cpu(cpu_for_slot(g_num_workers + i)); },
+                           [](int) { flush_stt(); });
+    }
+
+    // 会话在任何 worker 收包之前恢复完毕，再确认给旧进程
+    if (handoff_conn >= 0) {
+        size_t restored = restore_snapshot(snapshot);
+        snapshot = {};
+
+        if (!handoff::write_all(handoff_conn, &kHandoffAck, 1)) {
+            LOGE("[Handoff] previous process gave up before confirmation");
+            return -1;
+        }
+        close(handoff_conn);
+        LOGI("[Handoff] took over {} sockets and {} sessions", inherited.size(), restored);
+    }
+
+    // 所有 socket 绑定完成后再启动线程，避免启动期间 reuseport 组变化导致 4 元组改投
+    for (auto& w : g_workers) {
+        for (auto& lane : w->lanes) {
+            PipelineLane* l = lane.get();
+            int node = w->node;
+            std::thread([l, node] { place_on_node(node); apm_stage_thread(l); }).detach();
+            std::thread([l, node] { place_on_node(node); vad_stage_thread(l); }).detach();
+        }
+        std::thread(worker_thread, w.get()).detach();
+    }
+    log_topology();
+
+    std::thread(stats_reporter_thread).detach();
+    if (g_degrade_high_pct > 0) {
+        std::thread(load_controller_thread).detach();
+    }
+        // ai_response_thread 请自行根据您的 socket 需求补全
+     std::thread(ai_response_thread, g_ai_sock).detach();
+
+    if (!g_handoff_path.empty()) {
+        std::thread(handoff_listener_thread).detach();
+    }
+    std::thread(config_reload_thread).detach();
+
+    if (g_stt_shm) {
+        std::thread(stt_shm_listener_thread).detach();
+    }
 
-    LOGI("Gateway started, VAD={}",
-     g_vad_mode == VadMode::kWebRTC ? "WebRTC" :
-     g_vad_mode == VadMode::kTenVad ? "TenVAD" :
-                                      "Silero");
+    LOGI("Gateway started, VAD={} recv_batch={} workers={} lanes/worker={} sched={} io={} id={}",
+     vad_name(g_vad_mode), g_recv_batch, g_num_workers, g_pipeline_lanes, g_sched_threads,
+     g_io_engine == IoEngine::kUring ? "io_uring" : "socket",
+     g_id_wire == IdWire::kHex ? "hex" : "bin");
 
     while (true)
         std::this_thread::sleep_for(std::chrono::minutes(1));
@@ -0,0 +1,190 @@
+// alloc_check.cpp
+//
+// 稳态收包路径零堆分配的校验：把 main.cpp 整个编进来（main 改名），直接调用网关自己的
+// parse_media_packet → process_media（抖动缓冲 → 解码 → APM → VAD → STT 暂存）与 flush_stt。
+// 每个场景先用一个会话跑预热包（线程私有的统计 / 发送批次等首次登记、APM 内部缓冲区分配、
+// VAD 进入稳定状态），之后 N 个包整体放进 alloc_counter::Scope，计数不为 0 即失败。
+// 场景：VAD 引擎（WebRTC / TenVAD，找得到模型时加 Silero）× 报文（v1 抖动缓冲 / legacy）×
+// 输入（持续说话：STT 发送路径 / 静音），另加一组 stt_codec = opus 的说话场景。
+// 只覆盖直接处理模式（-p / -s 关闭）；流水线与调度器模式的线程私有分配见运行时 [Stats] allocs。
+//
+// 编译（在仓库根目录、build.sh 已跑过一次之后；必须打开 AEROSHELL_COUNT_ALLOCS）：
+//   APM=3rdparty/webrtc-audio-processing/install
+//   INC=$APM/include/webrtc-audio-processing-2
+//   CFLAGS="-I. -I$INC -I$INC/api/audio -I$INC/modules/audio_processing/include -I3rdparty/webrtc_vad/include -I3rdparty/ten_vad -I3rdparty/onnxruntime/include -I3rdparty/spdlog-1.17.0/include"
+//   LDFLAGS="-L$APM/lib/x86_64-linux-gnu -L3rdparty/webrtc_vad -L3rdparty/ten_vad -L3rdparty/onnxruntime/lib -Wl,-rpath,$PWD/$APM/lib/x86_64-linux-gnu:$PWD/3rdparty/ten_vad:$PWD/3rdparty/onnxruntime/lib"
+//   LIBS="-lten_vad -lwebrtc-audio-processing-2 -lwebrtc_vad -lonnxruntime -lopus -lpthread -lm"
+//   g++ -O2 -std=c++17 -DAEROSHELL_COUNT_ALLOCS $CFLAGS tools/alloc_check.cpp -o alloc_check $LDFLAGS $LIBS
+// 使用：
+//   ./alloc_check [测量包数，默认 3000] [Silero 模型，默认 3rdparty/silero_vad/silero_vad.onnx]
+// 退出码：0 = 所有场景测量窗口内零分配，1 = 有分配
+
+#define main aeroshell_main
+#include "../main.cpp"
+#undef main
+
+#include <cmath>
+#include <cstdio>
+
+static_assert(alloc_counter::enabled(), "alloc_check must be built with -DAEROSHELL_COUNT_ALLOCS");
+
+namespace {
+
+constexpr int kWarmupPackets = 300;   // 3 秒
+constexpr int kPacketMs      = 20;    // 客户端 20ms 一包：每包解码出两个 10ms 帧
+
+// 持续浊音（基频滑动的谐波，无停顿）或低电平底噪
+std::vector<int16_t> make_audio(int samples, bool voiced) {
+    std::vector<int16_t> pcm(size_t(samples), 0);
+    uint32_t seed = 12345;
+    double phase = 0;
+    for (int i = 0; i < samples; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        double noise = (double((seed >> 16) & 0x7fff) / 16384.0 - 1.0) * 30.0;
+        double v = 0;
+        if (voiced) {
+            double t = double(i) / kSampleRate;
+            double f0 = 140.0 + 30.0 * std::sin(2 * M_PI * 0.7 * t);
+            phase += 2 * M_PI * f0 / kSampleRate;
+            for (int h = 1; h <= 12; ++h) v += std::sin(h * phase) / h;
+            v *= 6000.0;
+        }
+        pcm[size_t(i)] = int16_t(std::clamp(v + noise, -32768.0, 32767.0));
+    }
+    return pcm;
+}
+
+// 预先编码好全部报文，测量窗口里只有网关自己的代码在跑
+std::vector<std::vector<uint8_t>> make_packets(int count, bool voiced, bool v1) {
+    int frame = kPacketMs * (kSampleRate / 1000);
+    std::vector<int16_t> pcm = make_audio(count * frame, voiced);
+
+    int err = 0;
+    OpusEncoder* enc = opus_encoder_create(kSampleRate, 1, OPUS_APPLICATION_VOIP, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(32000));
+
+    std::vector<std::vector<uint8_t>> out;
+    out.reserve(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        uint8_t opus[1275];   // Opus 单包上限
+        int n = opus_encode(enc, pcm.data() + size_t(i) * frame, frame, opus, sizeof(opus));
+        if (n <= 0) n = 0;
+
+        std::vector<uint8_t> pkt;
+        if (v1) {
+            uint16_t seq = uint16_t(i);
+            uint32_t ts  = uint32_t(i * frame);
+            pkt = {kPacketMagic, kPacketVersion,
+                   uint8_t(seq >> 8), uint8_t(seq),
+                   uint8_t(ts >> 24), uint8_t(ts >> 16), uint8_t(ts >> 8), uint8_t(ts),
+                   uint8_t(n >> 8), uint8_t(n)};
+        } else {
+            pkt = {uint8_t(n >> 8), uint8_t(n)};
+        }
+        pkt.insert(pkt.end(), opus, opus + n);
+        out.push_back(std::move(pkt));
+    }
+    opus_encoder_destroy(enc);
+    return out;
+}
+
+void use_config(bool opus_egress) {
+    auto c = std::make_unique<RuntimeConfig>(RuntimeConfig::defaults());
+    c->stt_port = 9;   // discard：STT 报文照常 sendmmsg，没有人收
+    c->stt_opus = opus_egress;
+    c->resolve();
+    c->version = g_config.read()->version + 1;
+    g_config.publish(std::move(c));
+    g_config.reclaim();
+}
+
+struct Scenario {
+    VadMode mode;
+    bool    v1;
+    bool    voiced;
+    bool    opus_egress;
+};
+
+bool run(const Scenario& sc, int measure, int sockfd) {
+    use_config(sc.opus_egress);
+
+    auto sess = std::make_unique<AudioSession>(sc.mode);
+    sess->sockfd = sockfd;
+    sess->apply_config(*g_config.read());
+
+    auto packets = make_packets(kWarmupPackets + measure, sc.voiced, sc.v1);
+    MediaStats ms;
+    StreamConfig sconf(kSampleRate, 1);
+
+    auto feed = [&](int i) {
+        const auto& p = packets[size_t(i)];
+        MediaPacket pkt;
+        if (parse_media_packet(p.data(), ssize_t(p.size()), pkt)) {
+            process_media(ms, sess.get(), pkt, now_us(), sconf);
+        }
+        flush_stt();
+    };
+
+    for (int i = 0; i < kWarmupPackets; ++i) feed(i);
+
+    bool started = sess->stt_started;
+    int  transitions = 0;
+    uint64_t frames0 = sess->deadline_frames;
+
+    alloc_counter::Scope scope;
+    for (int i = kWarmupPackets; i < kWarmupPackets + measure; ++i) {
+        feed(i);
+        if (sess->stt_started != started) {
+            started = sess->stt_started;
+            ++transitions;
+        }
+    }
+    uint64_t allocs = scope.allocations();
+
+    bool ok = allocs == 0;
+    std::printf("%-4s %-7s %-6s %-7s %-4s frames=%-6llu vad_transitions=%-3d allocations=%-6llu %s\n",
+                ok ? "ok" : "FAIL", vad_name(sc.mode), sc.v1 ? "v1" : "legacy",
+                sc.voiced ? "speech" : "silence", sc.opus_egress ? "opus" : "pcm",
+                (unsigned long long)(sess->deadline_frames - frames0), transitions,
+                (unsigned long long)allocs, started ? "(stt streaming)" : "");
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int measure = (argc > 1) ? std::atoi(argv[1]) : 3000;
+    if (measure <= 0) measure = 3000;
+    std::string model = (argc > 2) ? argv[2] : "3rdparty/silero_vad/silero_vad.onnx";
+
+    // VAD 起止日志不进测量结果：只保留错误
+    spdlog::set_level(spdlog::level::err);
+
+    std::vector<VadMode> modes = {VadMode::kWebRTC, VadMode::kTenVad};
+    try {
+        SileroVadDetector::Config cfg;
+        cfg.model_path  = model;
+        cfg.sample_rate = kSampleRate;
+        g_silero_vad = std::make_unique<SileroVadDetector>(cfg);
+        modes.insert(modes.begin(), VadMode::kSilero);
+    } catch (const std::exception& e) {
+        std::printf("silero model %s not loaded (%s), skipping Silero\n", model.c_str(), e.what());
+    }
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    bool ok = true;
+    for (VadMode m : modes) {
+        for (bool v1 : {true, false}) {
+            for (bool voiced : {true, false}) {
+                ok &= run({m, v1, voiced, false}, measure, sockfd);
+            }
+        }
+        ok &= run({m, true, true, true}, measure, sockfd);
+    }
+
+    close(sockfd);
+    std::printf("%s\n", ok ? "PASS: steady-state packet path is allocation-free"
+                           : "FAIL: allocations on the steady-state packet path");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// session_pool_bench.cpp
+//
+// 会话创建吞吐基准：对比新客户端到来时
+//   cold   — 现场构造（opus_decoder_create + AudioProcessingBuilder().Create() + VAD 句柄），
+//            会话结束时全部释放（旧版 AudioSession 的做法）
+//   pooled — 从预热池取出已构造好的会话，结束时原地重置
+//            （OPUS_RESET_STATE + apm->Initialize() + WebRtcVad_Init）后放回
+// 输出每秒可建立的会话数，以及单次创建的 p50 / p99 / max 耗时。
+//
+// 编译（在仓库根目录、build.sh 已跑过一次之后）：
+//   APM=3rdparty/webrtc-audio-processing/install
+//   INC=$APM/include/webrtc-audio-processing-2
+//   CFLAGS="-I$INC -I$INC/api/audio -I$INC/modules/audio_processing/include -I3rdparty/webrtc_vad/include"
+//   LDFLAGS="-L$APM/lib/x86_64-linux-gnu -Wl,-rpath,$APM/lib/x86_64-linux-gnu -L3rdparty/webrtc_vad"
+//   LIBS="-lwebrtc-audio-processing-2 -lwebrtc_vad -lopus -lpthread"
+//   g++ -O2 -std=c++17 $CFLAGS tools/session_pool_bench.cpp -o session_pool_bench $LDFLAGS $LIBS
+// 使用：
+//   ./session_pool_bench [会话数，默认 2000]
+
+#include <opus/opus.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audio_processing.h"
+#include "webrtc_vad.h"
+
+using namespace webrtc;
+
+static constexpr int kSampleRate = 16000;
+
+struct BenchSession {
+    std::unique_ptr<uint8_t[]> decoder_mem;
+    OpusDecoder* decoder = nullptr;
+    rtc::scoped_refptr<AudioProcessing> apm;
+    VadInst* vad = nullptr;
+
+    BenchSession() {
+        decoder_mem.reset(new uint8_t[opus_decoder_get_size(1)]);
+        decoder = reinterpret_cast<OpusDecoder*>(decoder_mem.get());
+        opus_decoder_init(decoder, kSampleRate, 1);
+
+        apm = AudioProcessingBuilder().Create();
+        AudioProcessing::Config cfg;
+        cfg.echo_canceller.enabled = true;
+        cfg.noise_suppression.enabled = true;
+        apm->ApplyConfig(cfg);
+
+        vad = WebRtcVad_Create();
+        WebRtcVad_Init(vad);
+        WebRtcVad_set_mode(vad, 3);
+    }
+
+    ~BenchSession() {
+        if (vad) WebRtcVad_Free(vad);
+    }
+
+    void recycle() {
+        opus_decoder_ctl(decoder, OPUS_RESET_STATE);
+        apm->Initialize();
+        WebRtcVad_Init(vad);
+        WebRtcVad_set_mode(vad, 3);
+    }
+};
+
+struct Result {
+    double per_sec;
+    double p50_us, p99_us, max_us;
+};
+
+template <class Create, class Destroy>
+static Result run(int n, Create&& create, Destroy&& destroy) {
+    std::vector<double> lat(n);
+    std::vector<std::unique_ptr<BenchSession>> live;
+    live.reserve(n);
+
+    auto t_all = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        live.push_back(create());
+        lat[i] = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+    double secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t_all).count();
+
+    for (auto& s : live) destroy(std::move(s));
+
+    std::sort(lat.begin(), lat.end());
+    return {n / secs, lat[n / 2], lat[size_t(n * 0.99)], lat.back()};
+}
+
+int main(int argc, char* argv[]) {
+    int n = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    if (n <= 0) n = 2000;
+
+    std::printf("%-8s %14s %10s %10s %10s\n", "mode", "sessions/s", "p50 us", "p99 us", "max us");
+
+    // ---------- 现场构造 / 析构 ----------
+    Result cold = run(
+        n,
+        [] { return std::make_unique<BenchSession>(); },
+        [](std::unique_ptr<BenchSession>) {});
+
+    // ---------- 预热池：先构造好 n 个，计时部分只有出池；归还时重置 ----------
+    std::mutex mu;
+    std::vector<std::unique_ptr<BenchSession>> pool;
+    for (int i = 0; i < n; ++i) pool.push_back(std::make_unique<BenchSession>());
+
+    auto acquire = [&] {
+        std::lock_guard<std::mutex> lk(mu);
+        auto s = std::move(pool.back());
+        pool.pop_back();
+        return s;
+    };
+    auto release = [&](std::unique_ptr<BenchSession> s) {
+        s->recycle();
+        std::lock_guard<std::mutex> lk(mu);
+        pool.push_back(std::move(s));
+    };
+
+    // 第一轮取出的是全新对象，第二轮才是重置过的，计第二轮
+    run(n, acquire, release);
+    Result pooled = run(n, acquire, release);
+
+    // ---------- 重置本身的开销（网关里由预热线程承担） ----------
+    auto t0 = std::chrono::steady_clock::now();
+    for (auto& s : pool) s->recycle();
+    double reset_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - t0).count() / n;
+
+    std::printf("%-8s %14.0f %10.1f %10.1f %10.1f\n",
+                "cold", cold.per_sec, cold.p50_us, cold.p99_us, cold.max_us);
+    std::printf("%-8s %14.0f %10.1f %10.1f %10.1f\n",
+                "pooled", pooled.per_sec, pooled.p50_us, pooled.p99_us, pooled.max_us);
+    std::printf("recycle (off hot path): %.1f us/session\n", reset_us);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// session_table_bench.cpp
+//
+// 会话查找微基准：对比旧版 "ip:port" 字符串 key + std::unordered_map + mutex
+// 与 SessionTable.hpp 中按 sockaddr 二进制 key 的开放寻址表，
+// 分别在 1k / 10k / 100k 会话规模下测单次查找耗时（含 key 构造）。
+//
+// 编译：
+//   g++ -O2 -std=c++17 -I.. session_table_bench.cpp -o session_table_bench -lpthread
+// 使用：
+//   ./session_table_bench [每种规模的查找次数，默认 5000000]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SessionTable.hpp"
+
+struct DummySession {
+    int id = 0;
+};
+
+// 与 main.cpp 旧版 receiver 完全一致的 key 构造方式
+static std::string legacy_key(const sockaddr_in& cli_addr) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &cli_addr.sin_addr, ip, sizeof(ip));
+    return std::string(ip) + ":" + std::to_string(ntohs(cli_addr.sin_port));
+}
+
+static std::vector<sockaddr_in> make_clients(size_t n, std::mt19937& gen) {
+    std::vector<sockaddr_in> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i].sin_family      = AF_INET;
+        v[i].sin_addr.s_addr = htonl(0x0a000000u | (gen() & 0x00ffffffu));
+        v[i].sin_port        = htons(uint16_t(1024 + gen() % 60000));
+    }
+    return v;
+}
+
+template <class F>
+static double ns_per_op(size_t ops, F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+    size_t lookups = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+
+    std::printf("%-10s %18s %18s %10s\n",
+                "sessions", "legacy ns/lookup", "flat ns/lookup", "speedup");
+
+    for (size_t n : {1000, 10000, 100000}) {
+        std::mt19937 gen(42);
+        auto clients = make_clients(n, gen);
+
+        // 查找序列预先生成，避免把随机数开销算进去
+        std::vector<uint32_t> order(lookups);
+        for (auto& o : order) o = gen() % n;
+
+        // ---------- 旧版 ----------
+        std::mutex mu;
+        std::unordered_map<std::string, std::shared_ptr<DummySession>> legacy;
+        for (size_t i = 0; i < n; ++i) {
+            legacy[legacy_key(clients[i])] = std::make_shared<DummySession>();
+        }
+
+        uint64_t sink = 0;
+        double legacy_ns = ns_per_op(lookups, [&] {
+            for (uint32_t idx : order) {
+                std::string key = legacy_key(clients[idx]);
+                std::lock_guard<std::mutex> lk(mu);
+                auto it = legacy.find(key);
+                sink += (it != legacy.end()) ? it->second->id + 1 : 0;
+            }
+        });
+
+        // ---------- 开放寻址表 ----------
+        FlatSessionTable<std::shared_ptr<DummySession>> flat;
+        for (size_t i = 0; i < n; ++i) {
+            *flat.try_emplace(SessionKey::from(clients[i])).first =
+                std::make_shared<DummySession>();
+        }
+
+        double flat_ns = ns_per_op(lookups, [&] {
+            for (uint32_t idx : order) {
+                auto* s = flat.find(SessionKey::from(clients[idx]));
+                sink += s ? (*s)->id + 1 : 0;
+            }
+        });
+
+        std::printf("%-10zu %18.1f %18.1f %9.1fx\n",
+                    n, legacy_ns, flat_ns, legacy_ns / flat_ns);
+
+        if (sink != 2 * lookups) {
+            std::fprintf(stderr, "lookup miss detected (sink=%llu)\n",
+                         (unsigned long long)sink);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+// session_teardown_bench.cpp
+//
+// 会话过期对收包线程的停顿：对比
+//   inline   — 收包线程持全局会话锁摘除会话，并在线程上直接写会话日志（同步落盘）、
+//              析构 Opus 解码器 / APM / VAD 句柄（旧版 session_cleaner 的做法）
+//   deferred — 锁内只摘指针，会话放入待回收队列，由后台线程写日志并重置 / 析构
+//              （当前网关：worker 只入队，会话池预热线程完成其余工作）
+// 同时有一个线程模拟 AI 回包查表，不断争用同一把全局锁。
+// 输出每次过期在收包线程上的停顿 p50 / p99 / max，以及 AI 线程拿锁的最长等待。
+// 网关运行时的同一指标见日志 [Stats] expire ...
+//
+// 编译（在仓库根目录、build.sh 已跑过一次之后）：
+//   APM=3rdparty/webrtc-audio-processing/install
+//   INC=$APM/include/webrtc-audio-processing-2
+//   CFLAGS="-I$INC -I$INC/api/audio -I$INC/modules/audio_processing/include -I3rdparty/webrtc_vad/include"
+//   LDFLAGS="-L$APM/lib/x86_64-linux-gnu -Wl,-rpath,$APM/lib/x86_64-linux-gnu -L3rdparty/webrtc_vad"
+//   LIBS="-lwebrtc-audio-processing-2 -lwebrtc_vad -lopus -lpthread"
+//   g++ -O2 -std=c++17 $CFLAGS tools/session_teardown_bench.cpp -o session_teardown_bench $LDFLAGS $LIBS
+// 使用：
+//   ./session_teardown_bench [会话数，默认 2000] [日志文件，默认 /tmp/teardown_bench.log]
+
+#include <opus/opus.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "audio_processing.h"
+#include "webrtc_vad.h"
+
+using namespace webrtc;
+
+static constexpr int kSampleRate = 16000;
+
+struct BenchSession {
+    int id = 0;
+    std::unique_ptr<uint8_t[]> decoder_mem;
+    OpusDecoder* decoder = nullptr;
+    rtc::scoped_refptr<AudioProcessing> apm;
+    VadInst* vad = nullptr;
+
+    explicit BenchSession(int i) : id(i) {
+        decoder_mem.reset(new uint8_t[opus_decoder_get_size(1)]);
+        decoder = reinterpret_cast<OpusDecoder*>(decoder_mem.get());
+        opus_decoder_init(decoder, kSampleRate, 1);
+
+        apm = AudioProcessingBuilder().Create();
+        AudioProcessing::Config cfg;
+        cfg.echo_canceller.enabled = true;
+        cfg.noise_suppression.enabled = true;
+        apm->ApplyConfig(cfg);
+
+        // 跑几帧，让 AEC3 / NS 的内部缓冲区真正分配出来
+        int16_t pcm[160] = {};
+        StreamConfig sc(kSampleRate, 1);
+        for (int k = 0; k < 10; ++k) {
+            apm->ProcessReverseStream(pcm, sc, sc, pcm);
+            apm->ProcessStream(pcm, sc, sc, pcm);
+        }
+
+        vad = WebRtcVad_Create();
+        WebRtcVad_Init(vad);
+        WebRtcVad_set_mode(vad, 3);
+    }
+
+    ~BenchSession() {
+        if (vad) WebRtcVad_Free(vad);
+    }
+
+    void log_summary(FILE* f) const {
+        // 与 spdlog flush_on(info) 相同：每行写完立即 fflush
+        std::fprintf(f, "[Session] destroyed %08x jb_depth=0 jitter=0.0ms late=0 lost=0\n", id);
+        std::fflush(f);
+    }
+};
+
+using Table = std::unordered_map<int, std::shared_ptr<BenchSession>>;
+
+struct Result {
+    double p50_us, p99_us, max_us;
+    double ai_wait_max_us;
+};
+
+static double pct(std::vector<double>& v, double q) {
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, size_t(q * v.size()))];
+}
+
+// AI 回包线程：反复持锁查表，记录最长等锁时间
+struct AiContender {
+    std::mutex& mu;
+    Table& table;
+    std::atomic<bool> stop{false};
+    double wait_max_us = 0;
+    std::thread th;
+
+    AiContender(std::mutex& m, Table& t) : mu(m), table(t) {
+        th = std::thread([this] {
+            int k = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto t0 = std::chrono::steady_clock::now();
+                {
+                    std::lock_guard<std::mutex> lk(mu);
+                    wait_max_us = std::max(wait_max_us,
+                        std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - t0).count());
+                    volatile bool hit = table.count(k++) != 0;
+                    (void)hit;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+    }
+
+    double finish() {
+        stop = true;
+        th.join();
+        return wait_max_us;
+    }
+};
+
+static Table build(int n) {
+    Table t;
+    for (int i = 0; i < n; ++i) t.emplace(i, std::make_shared<BenchSession>(i));
+    return t;
+}
+
+static Result run_inline(int n, FILE* log) {
+    std::mutex mu;
+    Table table = build(n);
+    AiContender ai(mu, table);
+
+    std::vector<double> stall(n);
+    for (int i = 0; i < n; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            auto it = table.find(i);
+            it->second->log_summary(log);
+            table.erase(it);   // 最后一个引用：在锁内析构
+        }
+        stall[i] = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+
+    double ai_wait = ai.finish();
+    return {pct(stall, 0.50), pct(stall, 0.99), pct(stall, 1.0), ai_wait};
+}
+
+static Result run_deferred(int n, FILE* log) {
+    std::mutex mu;
+    Table table = build(n);
+    AiContender ai(mu, table);
+
+    std::mutex qmu;
+    std::condition_variable qcv;
+    std::vector<std::shared_ptr<BenchSession>> queue;
+    bool done = false;
+
+    std::thread reaper([&] {
+        std::vector<std::shared_ptr<BenchSession>> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(qmu);
+                qcv.wait(lk, [&] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                batch.swap(queue);
+            }
+            for (auto& s : batch) s->log_summary(log);
+            batch.clear();   // 在后台线程析构
+        }
+    });
+
+    std::vector<double> stall(n);
+    for (int i = 0; i < n; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        std::shared_ptr<BenchSession> ref;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            auto it = table.find(i);
+            ref = std::move(it->second);
+            table.erase(it);
+        }
+        {
+            std::lock_guard<std::mutex> lk(qmu);
+            queue.push_back(std::move(ref));
+        }
+        qcv.notify_one();
+        stall[i] = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(qmu);
+        done = true;
+    }
+    qcv.notify_one();
+    reaper.join();
+
+    double ai_wait = ai.finish();
+    return {pct(stall, 0.50), pct(stall, 0.99), pct(stall, 1.0), ai_wait};
+}
+
+int main(int argc, char* argv[]) {
+    int n = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    if (n <= 0) n = 2000;
+    const char* path = (argc > 2) ? argv[2] : "/tmp/teardown_bench.log";
+
+    FILE* log = std::fopen(path, "w");
+    if (!log) {
+        std::perror(path);
+        return 1;
+    }
+
+    Result in  = run_inline(n, log);
+    Result def = run_deferred(n, log);
+    std::fclose(log);
+
+    std::printf("%-9s %10s %10s %10s %14s\n",
+                "mode", "p50 us", "p99 us", "max us", "ai wait max");
+    std::printf("%-9s %10.1f %10.1f %10.1f %14.1f\n",
+                "inline", in.p50_us, in.p99_us, in.max_us, in.ai_wait_max_us);
+    std::printf("%-9s %10.1f %10.1f %10.1f %14.1f\n",
+                "deferred", def.p50_us, def.p99_us, def.max_us, def.ai_wait_max_us);
+    return 0;
+}
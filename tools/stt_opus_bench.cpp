@@ -0,0 +1,159 @@
+// stt_opus_bench.cpp
+//
+// STT 出口 Opus 重编码（-C stt_codec = opus）的 CPU / 带宽取舍：
+// 对同一段 16 kHz 单声道音频，按 码率 × 帧长 × 复杂度 逐组用网关相同的编码器设置
+// （OPUS_APPLICATION_VOIP + OPUS_SIGNAL_VOICE，opus_encoder_init 到预分配内存）完整编码一遍，输出
+//   enc us/10ms — 每 10ms 音频的编码 CPU 时间（线程 CPU 时钟）
+//   sess/core   — 单核只做编码时可承载的同时说话会话数（10ms / 上一列）
+//   pkt/s       — 每路每秒报文数
+//   kbit/s      — 每路线路带宽：Opus 负载 + 10 字节帧头 + 16 字节会话 ID + 28 字节 IPv4/UDP 头
+//   vs PCM      — 相对 PCM 出口（stt_chunk_ms = 10，每帧 320 字节）的带宽比例
+// 开头先打印 PCM 出口在几种 stt_chunk_ms 下的线路带宽作为基线。
+// 不传音频文件时用合成的类语音信号（基频滑动的谐波 + 共振峰包络 + 音节间停顿 + 底噪）；
+// 码率相同时音质 / 识别率差异需用真实语料另行评估，这里只量化代价。
+//
+// 编译（在仓库根目录）：
+//   g++ -O2 -std=c++17 tools/stt_opus_bench.cpp -o stt_opus_bench -lopus
+// 使用：
+//   ./stt_opus_bench [音频秒数，默认 60] [16 kHz / mono / s16le 原始 PCM 文件]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <time.h>
+
+#include <opus/opus.h>
+
+static constexpr int kSampleRate = 16000;
+static constexpr int kFrameSize  = 160;   // 10ms
+static constexpr int kMaxPacket  = 1275;
+
+// 每个 STT 报文的线路开销：v1 帧头 + 会话 ID + IPv4 / UDP 头
+static constexpr int kOpusHeader = 10;
+static constexpr int kIdBytes    = 16;
+static constexpr int kIpUdp      = 28;
+
+static double thread_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+}
+
+static std::vector<int16_t> synth_speech(int seconds) {
+    std::vector<int16_t> pcm(size_t(seconds) * kSampleRate);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> noise(0.0, 60.0);
+
+    double phase = 0;
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        double t = double(i) / kSampleRate;
+        // 约 4 个音节 / 秒，音节之间留停顿
+        double syl = std::fmod(t * 4.0, 1.0);
+        double env = syl < 0.7 ? std::sin(M_PI * syl / 0.7) : 0.0;
+        double f0 = 120.0 + 40.0 * std::sin(2 * M_PI * 0.5 * t) + 20.0 * std::sin(2 * M_PI * 3.1 * t);
+        phase += 2 * M_PI * f0 / kSampleRate;
+
+        double v = 0;
+        for (int h = 1; h <= 20; ++h) {
+            double f = f0 * h;
+            if (f > 7000) break;
+            // 两个随音节移动的共振峰
+            double f1 = 500 + 300 * std::sin(2 * M_PI * 1.3 * t);
+            double f2 = 1500 + 600 * std::sin(2 * M_PI * 0.9 * t + 1.0);
+            double g = std::exp(-std::pow((f - f1) / 250, 2)) +
+                       0.6 * std::exp(-std::pow((f - f2) / 350, 2)) + 0.05;
+            v += g * std::sin(h * phase);
+        }
+        pcm[i] = int16_t(std::clamp(v * env * 3000 + noise(rng), -32768.0, 32767.0));
+    }
+    return pcm;
+}
+
+static bool load_pcm(const char* path, int seconds, std::vector<int16_t>& pcm) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    pcm.resize(size_t(seconds) * kSampleRate);
+    size_t n = std::fread(pcm.data(), sizeof(int16_t), pcm.size(), f);
+    std::fclose(f);
+    pcm.resize(n / kFrameSize * kFrameSize);
+    return !pcm.empty();
+}
+
+struct Result {
+    double enc_us_per_10ms;
+    double packets_per_sec;
+    double wire_kbps;
+};
+
+static Result run(const std::vector<int16_t>& pcm, int bitrate, int frame_ms, int complexity) {
+    std::unique_ptr<uint8_t[]> mem(new uint8_t[opus_encoder_get_size(1)]);
+    OpusEncoder* enc = reinterpret_cast<OpusEncoder*>(mem.get());
+    opus_encoder_init(enc, kSampleRate, 1, OPUS_APPLICATION_VOIP);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+    opus_encoder_ctl(enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+
+    int frame = frame_ms * (kSampleRate / 1000);
+    size_t frames = pcm.size() / size_t(frame);
+    uint8_t out[kMaxPacket];
+    uint64_t bytes = 0;
+
+    double c0 = thread_cpu_ns();
+    for (size_t i = 0; i < frames; ++i) {
+        int n = opus_encode(enc, pcm.data() + i * size_t(frame), frame, out, kMaxPacket);
+        if (n > 0) bytes += uint64_t(n + kOpusHeader + kIdBytes + kIpUdp);
+    }
+    double cpu = thread_cpu_ns() - c0;
+
+    double audio_sec = double(frames) * frame / kSampleRate;
+    return {cpu / 1000 / (audio_sec * 100), double(frames) / audio_sec,
+            double(bytes) * 8 / audio_sec / 1000};
+}
+
+int main(int argc, char* argv[]) {
+    int seconds = (argc > 1) ? std::atoi(argv[1]) : 60;
+    if (seconds <= 0) seconds = 60;
+
+    std::vector<int16_t> pcm;
+    if (argc > 2) {
+        if (!load_pcm(argv[2], seconds, pcm)) {
+            std::fprintf(stderr, "cannot read PCM from %s\n", argv[2]);
+            return 1;
+        }
+    } else {
+        pcm = synth_speech(seconds);
+    }
+    std::printf("%s, %.1f s of audio, libopus %s\n", argc > 2 ? argv[2] : "synthetic speech",
+                double(pcm.size()) / kSampleRate, opus_get_version_string());
+
+    // PCM 基线：stt_chunk_ms 决定每个报文的样本数
+    double pcm_kbps = 0;
+    std::printf("\n%-22s %10s %10s\n", "pcm egress", "pkt/s", "kbit/s");
+    for (int chunk_ms : {10, 20, 100, 200}) {
+        double pkts = 1000.0 / chunk_ms;
+        double kbps = pkts * (chunk_ms * (kSampleRate / 1000) * 2 + kIdBytes + kIpUdp) * 8 / 1000;
+        if (chunk_ms == 10) pcm_kbps = kbps;
+        std::printf("stt_chunk_ms=%-9d %10.0f %10.1f\n", chunk_ms, pkts, kbps);
+    }
+
+    std::printf("\n%8s %6s %4s %12s %10s %8s %10s %8s\n",
+                "bitrate", "frame", "cx", "enc us/10ms", "sess/core", "pkt/s", "kbit/s", "vs PCM");
+    for (int complexity : {0, 5, 10}) {
+        for (int bitrate : {8000, 16000, 24000, 32000, 64000}) {
+            for (int frame_ms : {10, 20, 40, 60}) {
+                Result r = run(pcm, bitrate, frame_ms, complexity);
+                std::printf("%8d %4dms %4d %12.1f %10.0f %8.0f %10.1f %7.1f%%\n",
+                            bitrate, frame_ms, complexity, r.enc_us_per_10ms,
+                            10000.0 / std::max(r.enc_us_per_10ms, 1e-3),
+                            r.packets_per_sec, r.wire_kbps, 100.0 * r.wire_kbps / pcm_kbps);
+            }
+        }
+    }
+    return 0;
+}
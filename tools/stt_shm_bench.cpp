@@ -0,0 +1,198 @@
+// stt_shm_bench.cpp
+//
+// STT 出口传输对比：P 个生产者线程（模拟网关处理线程）各自不停地发 10ms PCM 帧
+// （16 字节会话 ID + 320 字节 PCM），一个消费者线程（模拟同机 STT）全部收走。
+//   udp — 每帧一次 sendmsg 到 127.0.0.1，消费者 recvmmsg 批量接收（网关 -M 之前的做法）
+//   shm — 写入 SttShmRing（memfd 双重映射环），消费者用 tools/stt_shm_reader.c 读取
+// 输出每秒帧数、生产者 / 消费者每帧 CPU 时间，以及消费者实际收到且内容正确的比例
+// （UDP 接收缓冲溢出会丢帧）。为测可持续吞吐，shm 生产者遇到环满时让出 CPU 重试
+// （网关里是直接丢弃并计数），重试次数单独输出。
+//
+// 编译（在仓库根目录）：
+//   gcc -O2 -I. -c tools/stt_shm_reader.c -o stt_shm_reader.o
+//   g++ -O2 -std=c++17 -I. -Itools tools/stt_shm_bench.cpp stt_shm_reader.o -o stt_shm_bench -lpthread
+// 使用：
+//   ./stt_shm_bench [生产者线程数，默认 4] [每线程帧数，默认 500000]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ShmRing.hpp"
+#include "stt_shm_reader.h"
+
+static constexpr int    kFrameBytes = 320;
+static constexpr size_t kRingBytes  = 64u << 20;
+
+static double thread_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+}
+
+struct Result {
+    double frames_per_sec;
+    double prod_ns_per_frame;
+    double cons_ns_per_frame;
+    double received_pct;
+};
+
+template <class Produce, class Consume>
+static Result run(int producers, int frames, Produce&& produce, Consume&& consume) {
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> received{0};
+    double cons_cpu = 0;
+
+    std::thread consumer([&] {
+        double c0 = thread_cpu_ns();
+        received = consume(done);
+        cons_cpu = thread_cpu_ns() - c0;
+    });
+
+    std::vector<double> prod_cpu(producers);
+    std::vector<std::thread> th;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; ++p) {
+        th.emplace_back([&, p] {
+            uint8_t id[16];
+            std::memset(id, p + 1, sizeof(id));
+            uint8_t pcm[kFrameBytes];
+            std::memset(pcm, 0x5a, sizeof(pcm));
+
+            double c0 = thread_cpu_ns();
+            for (int i = 0; i < frames; ++i) {
+                produce(p, id, pcm);
+            }
+            prod_cpu[p] = thread_cpu_ns() - c0;
+        });
+    }
+    for (auto& t : th) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // 给消费者一点时间收尾
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    done = true;
+    consumer.join();
+
+    double total = double(producers) * frames;
+    double pcpu = 0;
+    for (double c : prod_cpu) pcpu += c;
+    return {total / secs, pcpu / total, cons_cpu / total, 100.0 * double(received) / total};
+}
+
+int main(int argc, char* argv[]) {
+    int producers = (argc > 1) ? std::atoi(argv[1]) : 4;
+    int frames    = (argc > 2) ? std::atoi(argv[2]) : 500000;
+    if (producers <= 0) producers = 4;
+    if (frames <= 0) frames = 500000;
+
+    /* ---------- UDP loopback ---------- */
+    int rx = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = 8 << 20;
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    timeval tv{0, 100000};
+    setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t alen = sizeof(addr);
+    getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &alen);
+
+    std::vector<int> tx(producers);
+    for (auto& fd : tx) fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    Result udp = run(
+        producers, frames,
+        [&](int p, const uint8_t* id, const uint8_t* pcm) {
+            iovec iov[2] = {{const_cast<uint8_t*>(id), 16},
+                            {const_cast<uint8_t*>(pcm), kFrameBytes}};
+            msghdr msg{};
+            msg.msg_name    = &addr;
+            msg.msg_namelen = sizeof(addr);
+            msg.msg_iov     = iov;
+            msg.msg_iovlen  = 2;
+            sendmsg(tx[p], &msg, 0);
+        },
+        [&](std::atomic<bool>& done) {
+            static constexpr int kBatch = 64;
+            std::vector<uint8_t> bufs(kBatch * 2048);
+            iovec iovs[kBatch];
+            mmsghdr msgs[kBatch];
+            for (int i = 0; i < kBatch; ++i) {
+                iovs[i] = {bufs.data() + i * 2048, 2048};
+                msgs[i] = {};
+                msgs[i].msg_hdr.msg_iov    = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            uint64_t n = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                int r = recvmmsg(rx, msgs, kBatch, MSG_WAITFORONE, nullptr);
+                if (r > 0) n += uint64_t(r);
+            }
+            return n;
+        });
+
+    for (int fd : tx) close(fd);
+    close(rx);
+
+    /* ---------- 共享内存环 ---------- */
+    std::string err;
+    auto ring = SttShmRing::create(kRingBytes, 16000, err);
+    if (!ring) {
+        std::fprintf(stderr, "ring: %s\n", err.c_str());
+        return 1;
+    }
+
+    Result shm = run(
+        producers, frames,
+        [&](int, const uint8_t* id, const uint8_t* pcm) {
+            while (!ring->write(STT_SHM_PCM, 0, id, pcm, kFrameBytes)) {
+                std::this_thread::yield();
+            }
+        },
+        [&](std::atomic<bool>& done) {
+            stt_shm_reader r;
+            if (stt_shm_attach(&r, ring->memfd(), ring->eventfd_fd()) != 0) {
+                std::perror("attach");
+                return uint64_t(0);
+            }
+            uint64_t n = 0;
+            auto count = [](void* ctx, const stt_shm_record* rec, const uint8_t* payload) {
+                // 模拟消费：校验负载首尾与会话 ID
+                if (rec->type == STT_SHM_PCM && rec->payload_len == kFrameBytes &&
+                    payload[0] == 0x5a && payload[kFrameBytes - 1] == 0x5a &&
+                    rec->session_id[0] == rec->session_id[15]) {
+                    ++*static_cast<uint64_t*>(ctx);
+                }
+            };
+            while (!done.load(std::memory_order_relaxed)) {
+                if (stt_shm_poll(&r, count, &n, 256) == 0) stt_shm_wait(&r, 100);
+            }
+            while (stt_shm_poll(&r, count, &n, 256) > 0) {}
+            stt_shm_close(&r);
+            return n;
+        });
+
+    std::printf("%d producers x %d frames (%d B PCM + 16 B id)\n", producers, frames, kFrameBytes);
+    std::printf("%-5s %14s %16s %16s %10s\n",
+                "mode", "frames/s", "producer ns/fr", "consumer ns/fr", "received");
+    std::printf("%-5s %14.0f %16.0f %16.0f %9.1f%%\n", "udp",
+                udp.frames_per_sec, udp.prod_ns_per_frame, udp.cons_ns_per_frame, udp.received_pct);
+    std::printf("%-5s %14.0f %16.0f %16.0f %9.1f%%\n", "shm",
+                shm.frames_per_sec, shm.prod_ns_per_frame, shm.cons_ns_per_frame, shm.received_pct);
+    std::printf("shm ring-full retries: %llu, reader wakeups: %llu\n",
+                (unsigned long long)ring->dropped(), (unsigned long long)ring->wakeups());
+    return 0;
+}
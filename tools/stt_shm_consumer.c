@@ -0,0 +1,196 @@
+/*
+ * stt_shm_consumer.c
+ *
+ * 共享内存 STT 环的本地替身消费者：连接网关 -M 指定的 socket，读出所有记录，
+ * 每秒打印记录数 / PCM 秒数 / Opus 帧数与字节数 / start / end 次数 / 网关侧丢弃数；
+ * 可选把每个语音段写成 <session_id>_<n>.pcm（16 kHz / mono / s16le），
+ * stt_codec = opus 时写成 <session_id>_<n>.opus（逐帧原样拼接，每帧带 10 字节帧头）。
+ * 网关重启（或热交接到新进程）后自动重连。
+ *
+ * 编译（在仓库根目录）：
+ *   gcc -O2 -I. tools/stt_shm_consumer.c tools/stt_shm_reader.c -o stt_shm_consumer
+ * 使用：
+ *   ./stt_shm_consumer <socket 路径> [输出目录]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stt_shm_reader.h"
+
+#define MAX_OPEN     256
+#define MAX_SESSIONS 65536   /* 记段号的会话数上限，2 的幂 */
+
+/* 正在落盘的语音段：start 时占位，第一条音频记录到来时按类型打开 .pcm / .opus */
+typedef struct {
+    uint8_t id[STT_SHM_ID_BYTES];
+    int     active;
+    int     segment;
+    FILE*   f;
+} open_segment;
+
+/* 每个会话 ID 已落盘的段数，跨重连保留，文件名不会互相覆盖 */
+typedef struct {
+    uint8_t id[STT_SHM_ID_BYTES];
+    int     used;
+    int     segments;
+} session_count;
+
+typedef struct {
+    const char*   out_dir;
+    open_segment  open[MAX_OPEN];
+    session_count counts[MAX_SESSIONS];
+    uint64_t      records, pcm_bytes, opus_frames, opus_bytes, starts, ends;
+} consumer;
+
+static void id_hex(const uint8_t* id, char* out) {
+    static const char* digits = "0123456789abcdef";
+    for (unsigned i = 0; i < STT_SHM_ID_BYTES; ++i) {
+        out[2 * i]     = digits[id[i] >> 4];
+        out[2 * i + 1] = digits[id[i] & 0xf];
+    }
+    out[2 * STT_SHM_ID_BYTES] = '\0';
+}
+
+/* 会话 ID 为随机数，直接取前 4 字节做线性探测的散列；表满返回 NULL */
+static session_count* find_count(consumer* c, const uint8_t* id) {
+    uint32_t h;
+    memcpy(&h, id, sizeof(h));
+    for (uint32_t n = 0; n < MAX_SESSIONS; ++n) {
+        session_count* e = &c->counts[(h + n) & (MAX_SESSIONS - 1)];
+        if (!e->used) {
+            e->used = 1;
+            memcpy(e->id, id, STT_SHM_ID_BYTES);
+            return e;
+        }
+        if (memcmp(e->id, id, STT_SHM_ID_BYTES) == 0) return e;
+    }
+    return NULL;
+}
+
+static open_segment* find_segment(consumer* c, const uint8_t* id, int create) {
+    open_segment* free_slot = NULL;
+    for (int i = 0; i < MAX_OPEN; ++i) {
+        if (c->open[i].active && memcmp(c->open[i].id, id, STT_SHM_ID_BYTES) == 0) return &c->open[i];
+        if (!c->open[i].active && !free_slot) free_slot = &c->open[i];
+    }
+    if (!create || !free_slot) return NULL;
+
+    session_count* n = find_count(c, id);
+    if (!n) return NULL;
+    memcpy(free_slot->id, id, STT_SHM_ID_BYTES);
+    free_slot->active  = 1;
+    free_slot->segment = n->segments++;
+    free_slot->f       = NULL;
+    return free_slot;
+}
+
+static void close_segment(open_segment* s) {
+    if (s->f) fclose(s->f);
+    s->f      = NULL;
+    s->active = 0;
+}
+
+/* OPUS 记录原样落盘（含 10 字节帧头，帧头里的 len 可逐帧切分） */
+static void write_audio(consumer* c, const stt_shm_record* rec, const uint8_t* payload) {
+    open_segment* s = find_segment(c, rec->session_id, 0);
+    if (!s) return;
+    if (!s->f) {
+        char hex[2 * STT_SHM_ID_BYTES + 1], path[1024];
+        id_hex(rec->session_id, hex);
+        snprintf(path, sizeof(path), "%s/%s_%d.%s", c->out_dir, hex, s->segment,
+                 rec->type == STT_SHM_OPUS ? "opus" : "pcm");
+        s->f = fopen(path, "wb");
+        if (!s->f) {
+            close_segment(s);
+            return;
+        }
+    }
+    fwrite(payload, 1, rec->payload_len, s->f);
+}
+
+static void on_record(void* ctx, const stt_shm_record* rec, const uint8_t* payload) {
+    consumer* c = (consumer*)ctx;
+    ++c->records;
+
+    switch (rec->type) {
+    case STT_SHM_START:
+        ++c->starts;
+        if (c->out_dir) find_segment(c, rec->session_id, 1);
+        break;
+    case STT_SHM_END:
+        ++c->ends;
+        if (c->out_dir) {
+            open_segment* s = find_segment(c, rec->session_id, 0);
+            if (s) close_segment(s);
+        }
+        break;
+    case STT_SHM_PCM:
+        c->pcm_bytes += rec->payload_len;
+        if (c->out_dir) write_audio(c, rec, payload);
+        break;
+    case STT_SHM_OPUS:
+        ++c->opus_frames;
+        c->opus_bytes += rec->payload_len;
+        if (c->out_dir) write_audio(c, rec, payload);
+        break;
+    default:
+        break;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <socket path> [output dir]\n", argv[0]);
+        return 1;
+    }
+
+    static consumer c;   /* 段号表较大，不放栈上 */
+    c.out_dir = (argc > 2) ? argv[2] : NULL;
+
+    for (;;) {
+        stt_shm_reader r;
+        if (stt_shm_connect(&r, argv[1]) != 0) {
+            perror("connect");
+            sleep(1);
+            continue;
+        }
+        fprintf(stderr, "attached, ring %llu bytes\n", (unsigned long long)r.capacity);
+
+        time_t last = time(NULL);
+        uint64_t last_rec = c.records, last_pcm = c.pcm_bytes;
+        uint64_t last_opus = c.opus_frames, last_opus_bytes = c.opus_bytes;
+
+        for (;;) {
+            if (stt_shm_poll(&r, on_record, &c, 256) == 0 && stt_shm_wait(&r, 1000) < 0) {
+                fprintf(stderr, "gateway disconnected\n");
+                break;
+            }
+
+            time_t now = time(NULL);
+            if (now != last) {
+                printf("records=%llu pcm=%.1fs opus=%llu frames / %.1f KB start=%llu end=%llu "
+                       "dropped=%llu\n",
+                       (unsigned long long)(c.records - last_rec),
+                       (double)(c.pcm_bytes - last_pcm) / (2.0 * 16000.0),
+                       (unsigned long long)(c.opus_frames - last_opus),
+                       (double)(c.opus_bytes - last_opus_bytes) / 1024.0,
+                       (unsigned long long)c.starts, (unsigned long long)c.ends,
+                       (unsigned long long)stt_shm_dropped(&r));
+                fflush(stdout);
+                last = now;
+                last_rec = c.records;
+                last_pcm = c.pcm_bytes;
+                last_opus = c.opus_frames;
+                last_opus_bytes = c.opus_bytes;
+            }
+        }
+
+        /* 新消费者收不到旧段的剩余记录（网关按代号跳过）：断开时收尾所有未结束的段 */
+        for (int i = 0; i < MAX_OPEN; ++i) close_segment(&c.open[i]);
+        stt_shm_close(&r);
+    }
+}
@@ -0,0 +1,197 @@
+/*
+ * stt_shm_reader.c —— 共享内存 STT 环消费端实现，接口说明见 stt_shm_reader.h
+ *
+ * 编译：gcc -O2 -c tools/stt_shm_reader.c -I. -o stt_shm_reader.o
+ */
+#define _GNU_SOURCE
+#include "stt_shm_reader.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int recv_two_fds(int sock, int* a, int* b) {
+    uint32_t count = 0;
+    struct iovec iov = { &count, sizeof(count) };
+    union {
+        char            buf[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr  align;
+    } ctrl;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)sizeof(count) || count != 2 || (msg.msg_flags & MSG_CTRUNC)) {
+        errno = EPROTO;
+        return -1;
+    }
+
+    struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS ||
+        c->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+        errno = EPROTO;
+        return -1;
+    }
+    int fds[2];
+    memcpy(fds, CMSG_DATA(c), sizeof(fds));
+    *a = fds[0];
+    *b = fds[1];
+    return 0;
+}
+
+static int map_ring(stt_shm_reader* r) {
+    struct stat st;
+    if (fstat(r->memfd, &st) < 0 || (uint64_t)st.st_size <= STT_SHM_HEADER_BYTES) {
+        errno = EPROTO;
+        return -1;
+    }
+    r->capacity = (uint64_t)st.st_size - STT_SHM_HEADER_BYTES;
+    r->span     = STT_SHM_HEADER_BYTES + 2 * r->capacity;
+
+    /* 与网关相同：头 + 数据区映射一次，数据区紧接着再映射一次 */
+    void* base = mmap(NULL, r->span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return -1;
+    r->base = (uint8_t*)base;
+    r->data = r->base + STT_SHM_HEADER_BYTES;
+
+    if (mmap(r->base, STT_SHM_HEADER_BYTES + r->capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, r->memfd, 0) == MAP_FAILED ||
+        mmap(r->data + r->capacity, r->capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, r->memfd, STT_SHM_HEADER_BYTES) == MAP_FAILED) {
+        return -1;
+    }
+
+    r->hdr = (stt_shm_header*)r->base;
+    if (__atomic_load_n(&r->hdr->magic, __ATOMIC_ACQUIRE) != STT_SHM_MAGIC ||
+        r->hdr->version != STT_SHM_VERSION || r->hdr->capacity != r->capacity) {
+        errno = EPROTO;
+        return -1;
+    }
+
+    /* 从上一个消费者停下的位置接着读并清零，但 epoch 之前的积压、旧代号的记录不交给回调 */
+    r->pos   = __atomic_load_n(&r->hdr->tail, __ATOMIC_ACQUIRE);
+    r->epoch = __atomic_load_n(&r->hdr->epoch, __ATOMIC_ACQUIRE);
+    r->gen   = __atomic_load_n(&r->hdr->gen, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int stt_shm_connect(stt_shm_reader* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->sock = r->memfd = r->efd = -1;
+
+    struct sockaddr_un a;
+    if (strlen(path) >= sizeof(a.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&a, 0, sizeof(a));
+    a.sun_family = AF_UNIX;
+    strcpy(a.sun_path, path);
+
+    r->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (r->sock < 0 ||
+        connect(r->sock, (struct sockaddr*)&a, sizeof(a)) < 0 ||
+        recv_two_fds(r->sock, &r->memfd, &r->efd) < 0 ||
+        map_ring(r) < 0) {
+        int e = errno;
+        stt_shm_close(r);
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
+int stt_shm_attach(stt_shm_reader* r, int memfd, int efd) {
+    memset(r, 0, sizeof(*r));
+    r->sock  = -1;
+    r->memfd = dup(memfd);
+    r->efd   = dup(efd);
+    if (r->memfd < 0 || r->efd < 0 || map_ring(r) < 0) {
+        int e = errno;
+        stt_shm_close(r);
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
+int stt_shm_poll(stt_shm_reader* r, stt_shm_callback cb, void* ctx, int max) {
+    uint64_t start = r->pos;
+    int n = 0;
+
+    while (n < max) {
+        stt_shm_record* rec = (stt_shm_record*)(r->data + (r->pos & (r->capacity - 1)));
+        uint32_t size = __atomic_load_n(&rec->size, __ATOMIC_ACQUIRE);
+        if (size == 0) break;   /* 尚未提交（或没有更多记录） */
+
+        if (r->pos >= r->epoch && rec->gen == r->gen) cb(ctx, rec, (const uint8_t*)(rec + 1));
+        r->pos += size;
+        ++n;
+    }
+
+    if (n > 0) {
+        /* 清零后再交还：以后落在这段区间里的记录头在提交前必须读到 0 */
+        memset(r->data + (start & (r->capacity - 1)), 0, (size_t)(r->pos - start));
+        __atomic_store_n(&r->hdr->tail, r->pos, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+int stt_shm_wait(stt_shm_reader* r, int timeout_ms) {
+    __atomic_store_n(&r->hdr->reader_waiting, 1u, __ATOMIC_SEQ_CST);
+
+    /* 置标志之后复查：生产者若在此之前提交，这里能看到，不必阻塞 */
+    stt_shm_record* rec = (stt_shm_record*)(r->data + (r->pos & (r->capacity - 1)));
+    if (__atomic_load_n(&rec->size, __ATOMIC_ACQUIRE) != 0) {
+        __atomic_store_n(&r->hdr->reader_waiting, 0u, __ATOMIC_RELAXED);
+        return 1;
+    }
+
+    struct pollfd p[2] = {
+        { r->efd,  POLLIN, 0 },
+        { r->sock, POLLIN, 0 },
+    };
+    int rc;
+    do {
+        rc = poll(p, 2, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    __atomic_store_n(&r->hdr->reader_waiting, 0u, __ATOMIC_RELAXED);
+
+    if (rc < 0) return -1;
+    if (r->sock >= 0 && (p[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+        /* 网关不会在这条连接上再发数据：可读即对端关闭 */
+        return -1;
+    }
+    if (p[0].revents & POLLIN) {
+        uint64_t v;
+        ssize_t n = read(r->efd, &v, sizeof(v));
+        (void)n;
+        return 1;
+    }
+    return 0;
+}
+
+uint64_t stt_shm_dropped(const stt_shm_reader* r) {
+    return __atomic_load_n(&r->hdr->dropped, __ATOMIC_RELAXED);
+}
+
+void stt_shm_close(stt_shm_reader* r) {
+    if (r->base) munmap(r->base, r->span);
+    if (r->memfd >= 0) close(r->memfd);
+    if (r->efd >= 0) close(r->efd);
+    if (r->sock >= 0) close(r->sock);
+    memset(r, 0, sizeof(*r));
+    r->sock = r->memfd = r->efd = -1;
+}
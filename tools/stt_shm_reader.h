@@ -0,0 +1,67 @@
+/*
+ * stt_shm_reader.h
+ *
+ * 共享内存 STT 环的消费端 C 库（网关 -M 模式），布局与提交协议见仓库根目录 SttShm.h。
+ *
+ * 用法：
+ *   stt_shm_reader r;
+ *   if (stt_shm_connect(&r, "/run/aeroshell-stt.sock") != 0) ...;
+ *   for (;;) {
+ *       if (stt_shm_poll(&r, on_record, ctx, 256) == 0 &&
+ *           stt_shm_wait(&r, 1000) < 0) break;       // 网关退出 / 断开
+ *   }
+ *   stt_shm_close(&r);
+ *
+ * 回调里拿到的记录与负载指针只在回调返回前有效（返回后该区间会被清零交还给网关）。
+ * 单线程使用；同一时刻网关只接受一个消费者。
+ */
+#ifndef AEROSHELL_STT_SHM_READER_H
+#define AEROSHELL_STT_SHM_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SttShm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct stt_shm_reader {
+    int             sock;       /* 与网关的 Unix 域连接，断开即表示网关退出 */
+    int             memfd;
+    int             efd;
+    uint8_t*        base;       /* 头 + 两份数据区的连续映射 */
+    size_t          span;
+    stt_shm_header* hdr;
+    uint8_t*        data;
+    uint64_t        capacity;
+    uint64_t        pos;        /* 下一条记录的位置 */
+    uint64_t        epoch;      /* 本消费者接入时的位置，之前的记录跳过 */
+    uint32_t        gen;        /* 本消费者的代号，其它代号的记录跳过 */
+} stt_shm_reader;
+
+typedef void (*stt_shm_callback)(void* ctx, const stt_shm_record* rec, const uint8_t* payload);
+
+/* 连接网关、接收 fd 并完成映射；成功返回 0，失败返回 -1（errno 有效） */
+int stt_shm_connect(stt_shm_reader* r, const char* path);
+
+/* 已经拿到 fd 时（例如同进程测试）直接映射，不建立连接；成功返回 0 */
+int stt_shm_attach(stt_shm_reader* r, int memfd, int efd);
+
+/* 非阻塞：按序处理最多 max 条已提交记录，返回处理条数（含不属于本消费者、被跳过的） */
+int stt_shm_poll(stt_shm_reader* r, stt_shm_callback cb, void* ctx, int max);
+
+/* 阻塞等待新记录：1 = 可能有数据，0 = 超时，-1 = 网关已断开 */
+int stt_shm_wait(stt_shm_reader* r, int timeout_ms);
+
+/* 环满丢弃数（网关侧计数） */
+uint64_t stt_shm_dropped(const stt_shm_reader* r);
+
+void stt_shm_close(stt_shm_reader* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AEROSHELL_STT_SHM_READER_H */